@@ -0,0 +1,369 @@
+/******************************************************************************
+* bench_host.c: fixture loop benchmark against the simulated CPLD
+*
+* Runs the loop body of main.c (Fixture_Cycle() and Fixture_Report()) for a
+* set of workloads and prints frames per second and p50/p99/max loop latency
+* per workload, one JSON object per line, so results can be compared between
+* commits. The console UART output of the loop goes to /dev/null; only its
+* formatting cost is measured.
+*
+*   gcc -std=c99 -O2 -DFIXTURE_HOST -DFIXTURE_BENCH -o fixture_bench *.c
+*   ./fixture_bench [-n frames] [-c case] [-t tag] [-f json|text]
+*
+* -c runs only the cases whose name contains the given text, -t adds a
+* "tag" field (e.g. the commit id) to every result.
+******************************************************************************/
+#if defined(FIXTURE_HOST) && defined(FIXTURE_BENCH)
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "fixture.h"
+#include "bram_cmd.h"
+#include "cpld_sim.h"
+#include "sweep.h"
+#include "ref_model.h"
+#include "decode.h"
+#include "soak.h"
+#include "timebase.h"
+#include "uart_cli.h"
+
+#define BENCH_LOOP			0	/* Fixture cycles at the current SHnum */
+#define BENCH_RELAYS		1	/* ChangeRequest toggling one relay per cycle */
+#define BENCH_SWEEP			2	/* Sweep_Run(), one handshake per point */
+#define BENCH_SWEEP_RING	3	/* Sweep_Run() through the command ring */
+#define BENCH_REPORT		4	/* Fixture_Report() alone, no handshake */
+#define BENCH_MODEL			5	/* RefModel_Check() alone on predicted responses */
+#define BENCH_SOAK			6	/* Soak_Run() in blocks of BENCH_SOAK_BLOCK frames */
+#define BENCH_DECODE		7	/* Decode_Batch() over a table of swept responses */
+#define BENCH_DECODE_SCALAR	8	/* Decode_BatchScalar() over the same table */
+
+#define BENCH_QUIET			0xFF	/* No per-cycle report */
+#define BENCH_MAX_FRAMES	1000000
+#define BENCH_DEFAULT_FRAMES	10000
+#define BENCH_SOAK_BLOCK	1000
+#define BENCH_MODEL_FRAMES	64
+#define BENCH_DECODE_TABLE	(8 * SWEEP_POINTS)
+
+typedef struct {
+	const char *Name;
+	u32 Workload;
+	u32 Output;				/* OUTPUT_* or BENCH_QUIET */
+	u32 TurnaroundNs;
+	u32 PingPong;
+} BenchCase;
+
+static const BenchCase Cases[] = {
+	{ "loop-text",			BENCH_LOOP,			OUTPUT_TEXT,	20000,	0 },
+	{ "loop-delta",			BENCH_LOOP,			OUTPUT_DELTA,	20000,	0 },
+	{ "loop-binary",		BENCH_LOOP,			OUTPUT_BINARY,	20000,	0 },
+	{ "loop-quiet",			BENCH_LOOP,			BENCH_QUIET,	20000,	0 },
+	{ "loop-trace",			BENCH_LOOP,			OUTPUT_TRACE,	20000,	0 },
+	{ "loop-stats",			BENCH_LOOP,			OUTPUT_STATS,	20000,	0 },
+	{ "loop-quiet-0us",		BENCH_LOOP,			BENCH_QUIET,	0,		0 },
+	{ "loop-quiet-2us",		BENCH_LOOP,			BENCH_QUIET,	2000,	0 },
+	{ "loop-quiet-100us",	BENCH_LOOP,			BENCH_QUIET,	100000,	0 },
+	{ "pingpong-quiet",		BENCH_LOOP,			BENCH_QUIET,	20000,	1 },
+	{ "relay-toggle",		BENCH_RELAYS,		OUTPUT_BINARY,	20000,	0 },
+	{ "sweep",				BENCH_SWEEP,		BENCH_QUIET,	20000,	0 },
+	{ "sweep-ring",			BENCH_SWEEP_RING,	BENCH_QUIET,	20000,	0 },
+	{ "report-text",		BENCH_REPORT,		OUTPUT_TEXT,	20000,	0 },
+	{ "report-delta",		BENCH_REPORT,		OUTPUT_DELTA,	20000,	0 },
+	{ "report-binary",		BENCH_REPORT,		OUTPUT_BINARY,	20000,	0 },
+	{ "model-check",		BENCH_MODEL,		BENCH_QUIET,	20000,	0 },
+	{ "soak",				BENCH_SOAK,			BENCH_QUIET,	20000,	0 },
+	{ "decode",				BENCH_DECODE,		BENCH_QUIET,	20000,	0 },
+	{ "decode-scalar",		BENCH_DECODE_SCALAR,	BENCH_QUIET,	20000,	0 },
+};
+
+typedef struct {
+	u32 Frames;
+	u32 Samples;			/* Latency samples, one per loop pass or sweep */
+	u64 ElapsedNs;
+	u32 P50Ns;
+	u32 P99Ns;
+	u32 MaxNs;
+	u32 Timeouts;
+	u32 Failed;			/* Soak frames that did not match the reference model */
+} BenchResult;
+
+static Fixture Fix;
+static SweepTable Sweep;
+static SoakResult Soak;
+static u32 Latency[BENCH_MAX_FRAMES];
+
+static int CompareU32(const void *a, const void *b)
+{
+	u32 x = *(const u32 *)a;
+	u32 y = *(const u32 *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+/*
+ * Time RefModel_Check() on its own: the responses are the model's own
+ * predictions for a ChangeRequest/DataUpdate mix starting with a ChangeRequest,
+ * so every one must match, also when the table wraps.
+ */
+static void RunModel(u32 Frames, BenchResult *R)
+{
+	static u32 Command[BENCH_MODEL_FRAMES][CMD_WORDS];
+	static u32 Response[BENCH_MODEL_FRAMES][RSP_WORDS];
+	FixtureConfig Config = Fix.Config;
+	RefModel Model;
+	u32 Care[RSP_WORDS];
+	u32 Mismatch = 0;
+	u64 Start;
+	u32 n;
+
+	RefModel_Init(&Model);
+	for (n = 0; n < BENCH_MODEL_FRAMES; n++) {
+		Config.CommandType = (n & 3) == 3 ? DataUpdate : ChangeRequest;
+		Config.Relays = n % (RELAY_ALL + 1);
+		Config.Threshold = n & 3;
+		BramCmd_BuildFrame(&Config, (u8)n, Command[n]);
+		RefModel_Expect(&Model, Command[n], Response[n], Care);
+		RefModel_Check(&Model, Command[n], Response[n]);
+	}
+
+	RefModel_Init(&Model);
+	for (n = 0; n < Frames; n++) {
+		Start = Time_Now();
+		Mismatch |= RefModel_Check(&Model, Command[n % BENCH_MODEL_FRAMES],
+				Response[n % BENCH_MODEL_FRAMES]);
+		Latency[R->Samples++] = (u32)(Time_Now() - Start);
+	}
+	R->Frames = Frames;
+	if (Mismatch) {
+		fprintf(stderr, "model-check: mismatch 0x%x\n", (unsigned)Mismatch);
+	}
+}
+
+static u32 DecodeTable[BENCH_DECODE_TABLE][RSP_WORDS];
+static u8 DecodeField[2][4][BENCH_DECODE_TABLE];
+
+/*
+ * Fill the decode table from sweeps of every relay mask, outside the timed
+ * part, and check the batch decoder against the scalar version on it.
+ */
+static void PrepareDecode(const BenchCase *C)
+{
+	DecodeFields Out = { DecodeField[0][0], DecodeField[0][1], DecodeField[0][2], DecodeField[0][3] };
+	DecodeFields Check = { DecodeField[1][0], DecodeField[1][1], DecodeField[1][2], DecodeField[1][3] };
+	FixtureConfig Config = Fix.Config;
+	DecodeCounts Counts;
+	DecodeCounts Expected;
+	u32 n;
+
+	Config.CommandType = ChangeRequest;
+	for (n = 0; n < BENCH_DECODE_TABLE; n += SWEEP_POINTS) {
+		Config.Relays = (n / SWEEP_POINTS) % (RELAY_ALL + 1);
+		Sweep_Run(&Sweep, &Fix.Cache, &Config, 0);
+		memcpy(DecodeTable[n], Sweep.Data, sizeof(Sweep.Data));
+	}
+	Fixture_SetPingPong(&Fix, C->PingPong);
+
+	Decode_Batch((const u32 (*)[RSP_WORDS])DecodeTable, BENCH_DECODE_TABLE, &Out, &Counts);
+	Decode_BatchScalar((const u32 (*)[RSP_WORDS])DecodeTable, BENCH_DECODE_TABLE, &Check, &Expected);
+	if (memcmp(&Counts, &Expected, sizeof(Counts)) != 0 ||
+			memcmp(DecodeField[0], DecodeField[1], sizeof(DecodeField[0])) != 0) {
+		fprintf(stderr, "decode: batch and scalar results differ\n");
+	}
+}
+
+/* Time the batch decoder, or its scalar version, on the prepared table */
+static void RunDecode(const BenchCase *C, u32 Frames, BenchResult *R)
+{
+	DecodeFields Out = { DecodeField[0][0], DecodeField[0][1], DecodeField[0][2], DecodeField[0][3] };
+	DecodeCounts Counts;
+	u64 Start;
+
+	R->Frames = 0;
+	while (R->Frames + BENCH_DECODE_TABLE <= Frames) {
+		Start = Time_Now();
+		if (C->Workload == BENCH_DECODE) {
+			Decode_Batch((const u32 (*)[RSP_WORDS])DecodeTable, BENCH_DECODE_TABLE, &Out, &Counts);
+		}
+		else {
+			Decode_BatchScalar((const u32 (*)[RSP_WORDS])DecodeTable, BENCH_DECODE_TABLE, &Out, &Counts);
+		}
+		Latency[R->Samples++] = (u32)(Time_Now() - Start);
+		R->Frames += BENCH_DECODE_TABLE;
+	}
+}
+
+static void RunCase(const BenchCase *C, u32 Frames, BenchResult *R)
+{
+	CpldSim_Config Config;
+	u64 Start;
+	u64 Begin;
+	u32 n;
+
+	CpldSim_GetConfig(&Config);
+	Config.TurnaroundNs = C->TurnaroundNs;
+	CpldSim_Configure(&Config);
+
+	Fixture_Start(&Fix);
+	Fix.OutputMode = C->Output == BENCH_QUIET ? OUTPUT_BINARY : (u8)C->Output;
+	Fixture_SetPingPong(&Fix, C->PingPong);
+
+	R->Timeouts = Fix.Timeouts;
+	R->Samples = 0;
+	R->Failed = 0;
+	if (C->Workload == BENCH_DECODE || C->Workload == BENCH_DECODE_SCALAR) {
+		PrepareDecode(C);
+	}
+	Begin = Time_Now();
+	if (C->Workload == BENCH_SWEEP || C->Workload == BENCH_SWEEP_RING) {
+		R->Frames = 0;
+		while (R->Frames + SWEEP_POINTS <= Frames) {
+			Start = Time_Now();
+			Sweep_Run(&Sweep, &Fix.Cache, &Fix.Config, C->Workload == BENCH_SWEEP_RING);
+			Latency[R->Samples++] = (u32)(Time_Now() - Start);
+			Fix.Timeouts += Sweep.Timeouts;
+			R->Frames += SWEEP_POINTS;
+		}
+		Fixture_SetPingPong(&Fix, C->PingPong);
+	}
+	else if (C->Workload == BENCH_DECODE || C->Workload == BENCH_DECODE_SCALAR) {
+		RunDecode(C, Frames, R);
+	}
+	else if (C->Workload == BENCH_MODEL) {
+		RunModel(Frames, R);
+	}
+	else if (C->Workload == BENCH_SOAK) {
+		R->Frames = 0;
+		while (R->Frames + BENCH_SOAK_BLOCK <= Frames) {
+			Start = Time_Now();
+			if (Soak_Run(&Soak, &Fix.Config, BENCH_SOAK_BLOCK, R->Frames + 1) != XST_SUCCESS) {
+				R->Failed += Soak.Failed;
+			}
+			Latency[R->Samples++] = (u32)(Time_Now() - Start);
+			Fix.Timeouts += Soak.Lost;
+			R->Frames += BENCH_SOAK_BLOCK;
+		}
+		Fixture_SetPingPong(&Fix, C->PingPong);
+		if (R->Failed) {
+			fprintf(stderr, "soak: %u of %u frames failed\n", R->Failed, R->Frames);
+		}
+	}
+	else if (C->Workload == BENCH_REPORT) {
+		Fixture_Cycle(&Fix);
+		for (n = 0; n < Frames; n++) {
+			Start = Time_Now();
+			Fix.Data[2] ^= 1u << (n % 5);	/* Something for the delta view to redraw */
+			Fixture_Report(&Fix);
+			Latency[R->Samples++] = (u32)(Time_Now() - Start);
+		}
+		R->Frames = Frames;
+	}
+	else {
+		for (n = 0; n < Frames; n++) {
+			Start = Time_Now();
+			if (C->Workload == BENCH_RELAYS) {
+				Fix.Config.CommandType = ChangeRequest;
+				Fix.Config.Relays ^= 1u << (n % 5);
+			}
+			if (Fixture_Cycle(&Fix) != XST_NO_DATA && C->Output != BENCH_QUIET) {
+				Fixture_Report(&Fix);
+			}
+			Latency[R->Samples++] = (u32)(Time_Now() - Start);
+		}
+		R->Frames = Frames;
+	}
+	R->ElapsedNs = Time_Now() - Begin;
+	R->Timeouts = Fix.Timeouts - R->Timeouts;
+	UartCli_Flush();
+
+	qsort(Latency, R->Samples, sizeof(Latency[0]), CompareU32);
+	R->P50Ns = R->Samples ? Latency[(R->Samples - 1) / 2] : 0;
+	R->P99Ns = R->Samples ? Latency[(u32)((u64)(R->Samples - 1) * 99 / 100)] : 0;
+	R->MaxNs = R->Samples ? Latency[R->Samples - 1] : 0;
+}
+
+static void PrintResult(FILE *Out, const BenchCase *C, const BenchResult *R,
+		const char *Tag, int Json)
+{
+	double Fps = R->ElapsedNs ? (double)R->Frames * 1e9 / (double)R->ElapsedNs : 0.0;
+
+	if (Json) {
+		fprintf(Out, "{\"case\":\"%s\",", C->Name);
+		if (Tag != NULL) {
+			fprintf(Out, "\"tag\":\"%s\",", Tag);
+		}
+		fprintf(Out, "\"frames\":%u,\"turnaround_ns\":%u,\"fps\":%.1f,"
+				"\"p50_ns\":%u,\"p99_ns\":%u,\"max_ns\":%u,\"timeouts\":%u,\"failed\":%u}\n",
+				R->Frames, C->TurnaroundNs, Fps, R->P50Ns, R->P99Ns, R->MaxNs, R->Timeouts, R->Failed);
+	}
+	else {
+		fprintf(Out, "%-18s %8u frames %10.0f fps  p50 %8u ns  p99 %8u ns  max %9u ns  %u timeouts  %u failed\n",
+				C->Name, R->Frames, Fps, R->P50Ns, R->P99Ns, R->MaxNs, R->Timeouts, R->Failed);
+	}
+	fflush(Out);
+}
+
+int main(int argc, char *argv[])
+{
+	const char *Only = NULL;
+	const char *Tag = NULL;
+	u32 Frames = BENCH_DEFAULT_FRAMES;
+	int Json = 1;
+	int Status = 0;
+	BenchResult R;
+	FILE *Out;
+	u32 i;
+	int Opt;
+
+	while ((Opt = getopt(argc, argv, "n:c:t:f:")) != -1) {
+		switch (Opt) {
+		case 'n':
+			Frames = (u32)strtoul(optarg, NULL, 0);
+			break;
+		case 'c':
+			Only = optarg;
+			break;
+		case 't':
+			Tag = optarg;
+			break;
+		case 'f':
+			Json = strcmp(optarg, "text") != 0;
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-n frames] [-c case] [-t tag] [-f json|text]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (Frames == 0 || Frames > BENCH_MAX_FRAMES) {
+		Frames = BENCH_MAX_FRAMES;
+	}
+
+	/* Results go to the real stdout, the simulated console UART to /dev/null */
+	Out = fdopen(dup(STDOUT_FILENO), "w");
+	if (Out == NULL || freopen("/dev/null", "w", stdout) == NULL) {
+		perror("fixture_bench");
+		return 1;
+	}
+
+	UartCli_Init(UART_BAUD_RATE);
+	if (BramCmd_Init() != XST_SUCCESS) {
+		return 1;
+	}
+	Fixture_Init(&Fix);
+
+	for (i = 0; i < sizeof(Cases) / sizeof(Cases[0]); i++) {
+		if (Only != NULL && strstr(Cases[i].Name, Only) == NULL) {
+			continue;
+		}
+		RunCase(&Cases[i], Frames, &R);
+		PrintResult(Out, &Cases[i], &R, Tag, Json);
+		if (R.Failed) {
+			Status = 1;
+		}
+	}
+
+	fclose(Out);
+	return Status;
+}
+
+#endif /* FIXTURE_HOST && FIXTURE_BENCH */
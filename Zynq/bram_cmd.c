@@ -1 +1,667 @@
+/******************************************************************************
+* bram_cmd.c: BRAM command/response and handshake GPIO access
+******************************************************************************/
+#include <stddef.h>
+#include <string.h>
+#include "bram_cmd.h"
+#include "timebase.h"
 
+/* One bit field of the COMMAND frame, taken from a FixtureConfig member */
+typedef struct {
+	u8 Word;				/* Frame index, 0 = Command1 */
+	u8 Pos;
+	u8 Width;
+	u8 Member;				/* offsetof(FixtureConfig, ...) */
+} FrameField;
+
+static const FrameField CommandFields[] = {
+	{ 0, POS_Pos,			3, offsetof(FixtureConfig, Pos) },
+	{ 0, POS_BoardId,		4, offsetof(FixtureConfig, BoardId) },
+	{ 1, POS_CommandType,	2, offsetof(FixtureConfig, CommandType) },
+	{ 1, POS_ModId,			2, offsetof(FixtureConfig, ModId) },
+	{ 1, POS_Threshold,		2, offsetof(FixtureConfig, Threshold) },
+	{ 1, POS_DryWet,		1, offsetof(FixtureConfig, DryWet) },
+	{ 1, POS_Synch,			1, offsetof(FixtureConfig, Synchronization) },
+	{ 2, 0,					5, offsetof(FixtureConfig, Relays) },
+};
+
+/****************************************************************************/
+/**
+*
+* Encode a complete COMMAND frame: HEADER with POS and BOARD_ID, Command2 with
+* the SHnum in its low byte, Command3, its inversion Command4, and FOOTER.
+*
+* @param	Config is the commanded fixture state.
+* @param	SHnum is the Sample and Hold number.
+* @param	Frame receives CMD_WORDS words.
+*
+* @return	None.
+*
+*****************************************************************************/
+void BramCmd_BuildFrame(const FixtureConfig *Config, u8 SHnum, u32 *Frame)
+{
+	const FrameField *Field;
+	u32 Value;
+	u32 i;
+
+	Frame[0] = FRAME_HEADER & 0xFF00;
+	Frame[1] = SHnum;
+	Frame[2] = FRAME_COMMAND3;
+	for (i = 0; i < sizeof(CommandFields) / sizeof(CommandFields[0]); i++) {
+		Field = &CommandFields[i];
+		Value = *(const u32 *)((const u8 *)Config + Field->Member);
+		Frame[Field->Word] |= (Value & ((1u << Field->Width) - 1)) << Field->Pos;
+	}
+	Frame[3] = 0x0000FFFF & ~Frame[2];	// Inversion of Command3
+	Frame[4] = FRAME_FOOTER;
+}
+
+/*
+ * Inverse of BramCmd_BuildFrame(): the configuration and SHnum a frame was
+ * built from, for frames read back from a recording.
+ */
+void BramCmd_ParseFrame(const u32 *Frame, FixtureConfig *Config, u8 *SHnum)
+{
+	const FrameField *Field;
+	u32 i;
+
+	for (i = 0; i < sizeof(CommandFields) / sizeof(CommandFields[0]); i++) {
+		Field = &CommandFields[i];
+		*(u32 *)((u8 *)Config + Field->Member) =
+				(Frame[Field->Word] >> Field->Pos) & ((1u << Field->Width) - 1);
+	}
+	*SHnum = (u8)Frame[1];
+}
+
+/*
+ * Return the frame for SHnum, rebuilding the whole table first if Config is
+ * not the configuration it was built for.
+ */
+const u32 *BramCmd_CachedFrame(FrameCache *Cache, const FixtureConfig *Config, u8 SHnum)
+{
+	u32 Sh;
+
+	if (!Cache->Valid || memcmp(&Cache->Config, Config, sizeof(*Config)) != 0) {
+		Cache->Config = *Config;
+		for (Sh = 0; Sh <= SHNUM_WRAP; Sh++) {
+			BramCmd_BuildFrame(Config, (u8)Sh, Cache->Frame[Sh]);
+		}
+		Cache->Valid = 1;
+	}
+	return Cache->Frame[SHnum];
+}
+
+void BramCmd_InvalidateCache(FrameCache *Cache)
+{
+	Cache->Valid = 0;
+}
+
+typedef int (*WaitCond)(u32 Arg);
+
+static int WaitFor(WaitCond Ready, u32 Arg, u64 Deadline);
+
+static int HandshakeSet(u32 Mask)
+{
+	return (BramCmd_ReadHandshake() & Mask) != 0;
+}
+
+static int ResponseCountIs(u32 Arg)
+{
+	return BramCmd_ResponseCount(Arg >> 16) == (Arg & 0xFFFF);
+}
+
+static int RingTailReached(u32 Tail)
+{
+	return (s32)(BramCmd_RingTail() - Tail) >= 0;
+}
+
+/*
+ * Wait for a handshake input bit (HS_READ_EN or HS_WRITE_EN) to go high.
+ * Returns XST_FAILURE if Deadline (a Time_Now() value) passes first.
+ */
+int BramCmd_WaitHandshake(u32 Mask, u64 Deadline)
+{
+	return WaitFor(HandshakeSet, Mask, Deadline);
+}
+
+/*
+ * Ping-pong mode: wait for the response count of BRAM1 slot Slot to reach
+ * Count. ReadEn toggles with every posted response, which wakes the wait.
+ */
+int BramCmd_WaitResponse(u32 Slot, u16 Count, u64 Deadline)
+{
+	return WaitFor(ResponseCountIs, (Slot << 16) | Count, Deadline);
+}
+
+/*
+ * Ring mode: wait until the CPLD has consumed at least Tail frames.
+ */
+int BramCmd_WaitRingTail(u32 Tail, u64 Deadline)
+{
+	return WaitFor(RingTailReached, Tail, Deadline);
+}
+
+u16 BramCmd_ResponseCount(u32 Slot)
+{
+	return (u16)BramCmd_ReadResponse(Slot * PP_SLOT_STRIDE + PP_DONE_OFFSET);
+}
+
+void BramCmd_SetMode(u32 Mode)
+{
+	BramCmd_WriteCommand(BRAM0_MODE_OFFSET, Mode);
+}
+
+void BramCmd_RingPost(u32 Head)
+{
+	BramCmd_WriteCommand(RING_HEAD_OFFSET, Head);
+}
+
+u32 BramCmd_RingTail(void)
+{
+	return BramCmd_ReadResponse(RING_TAIL_OFFSET);
+}
+
+void BramCmd_WriteFrame(const u32 *Frame)
+{
+	BramCmd_WriteSlot(0, Frame);
+}
+
+void BramCmd_ReadFrame(u32 *Response)
+{
+	BramCmd_ReadSlot(0, Response);
+}
+
+/* Per-frame time of Ticks over Iterations frames, less the timer reads */
+static void PrintAccessTime(const char *Name, u64 Ticks, u64 Overhead, u32 Iterations)
+{
+	Ticks = Ticks > Overhead ? Ticks - Overhead : 0;
+	xil_printf("  %s %d ns/frame", Name, (u32)(Time_TicksToUs(Ticks * 1000) / Iterations));
+#ifdef BRAM_CPU_HZ
+	xil_printf(", %d CPU cycles/frame", (u32)(Ticks * BRAM_CPU_HZ / Time_TicksPerSecond() / Iterations));
+#endif
+	xil_printf("\r\n");
+}
+
+/****************************************************************************/
+/**
+*
+* Time the BRAM accesses of Iterations frames, first with one register
+* access per word as the base application did, then with BramCmd_WriteFrame()
+* and BramCmd_ReadFrame(). Every frame is a real single-mode handshake (write,
+* ReadEn, read); only the write and the read are timed, not the CPLD. BRAM0
+* is left in single mode, so the caller restores its mode afterwards.
+*
+* @param	Frame is the COMMAND frame sent, a DataUpdate so that the
+*		relays stay as commanded.
+* @param	Iterations is the number of frames timed per method.
+*
+* @return	XST_SUCCESS, or XST_FAILURE if a handshake timed out.
+*
+*****************************************************************************/
+int BramCmd_Benchmark(const u32 *Frame, u32 Iterations)
+{
+	u32 Response[RSP_WORDS];
+	u64 Time[2] = { 0, 0 };
+	u64 Overhead = 0;
+	u64 Start;
+	u32 Method;
+	u32 n;
+	u32 i;
+
+	/* Two timed sections per frame, each costing two Time_Now() calls */
+	for (n = 0; n < 2 * Iterations; n++) {
+		Start = Time_Now();
+		Overhead += Time_Now() - Start;
+	}
+
+	BramCmd_SetMode(BRAM_MODE_SINGLE);
+	for (Method = 0; Method < 2; Method++) {
+		for (n = 0; n < Iterations; n++) {
+			if (FIXTURE_WAIT_WRITE_EN && BramCmd_WaitHandshake(HS_WRITE_EN,
+					Time_Now() + Time_UsToTicks(FIXTURE_READEN_TIMEOUT_US)) != XST_SUCCESS) {
+				break;
+			}
+			Start = Time_Now();
+			if (Method == 0) {
+				for (i = 0; i < CMD_WORDS; i++) {
+					BramCmd_WriteCommand(i * 4, Frame[i]);
+				}
+			}
+			else {
+				BramCmd_WriteFrame(Frame);
+			}
+			Time[Method] += Time_Now() - Start;
+
+			if (BramCmd_WaitHandshake(HS_READ_EN,
+					Time_Now() + Time_UsToTicks(FIXTURE_READEN_TIMEOUT_US)) != XST_SUCCESS) {
+				break;
+			}
+			Start = Time_Now();
+			if (Method == 0) {
+				for (i = 0; i < RSP_WORDS; i++) {
+					Response[i] = BramCmd_ReadResponse(i * 4);
+				}
+			}
+			else {
+				BramCmd_ReadFrame(Response);
+			}
+			Time[Method] += Time_Now() - Start;
+		}
+		if (n < Iterations) {
+			xil_printf("BRAM benchmark: handshake timeout after %d frames\r\n", n);
+			return XST_FAILURE;
+		}
+	}
+
+	xil_printf("BRAM frame write+read, %d handshaked frames:\r\n", Iterations);
+	PrintAccessTime("per word:", Time[0], Overhead, Iterations);
+	PrintAccessTime("burst:   ", Time[1], Overhead, Iterations);
+	return XST_SUCCESS;
+}
+
+#ifndef FIXTURE_HOST
+#include "xparameters.h"
+#include "xbram.h"
+#include "xgpio.h"
+#include "xil_exception.h"
+#include "xpseudo_asm.h"
+#include "intc.h"
+
+#define BRAM0_DEVICE_ID		XPAR_BRAM_0_DEVICE_ID
+#define BRAM1_DEVICE_ID		XPAR_BRAM_1_DEVICE_ID
+#define BRAM0_BASEADDR		XPAR_AXI_BRAM_CTRL_0_S_AXI_BASEADDR
+#define BRAM1_BASEADDR		XPAR_AXI_BRAM_CTRL_1_S_AXI_BASEADDR
+
+#define INPUT_CHANNEL 		1
+#define OUTPUT_CHANNEL 		1
+#define INPUT_DEVICE_ID 	XPAR_AXI_GPIO_INPUT_DEVICE_ID
+#define OUTPUT_DEVICE_ID	XPAR_AXI_GPIO_OUTPUT_DEVICE_ID
+
+/* ReadEn/WriteEn interrupt, present when the INPUT GPIO has its IP2INTC output wired to the GIC */
+#ifdef XPAR_FABRIC_AXI_GPIO_INPUT_IP2INTC_IRPT_INTR
+#define INPUT_INTR_ID		XPAR_FABRIC_AXI_GPIO_INPUT_IP2INTC_IRPT_INTR
+#endif
+
+static int BramInit(XBram *InstancePtr, u16 DeviceId);
+static void InitializeECC(XBram_Config *ConfigPtr, u32 EffectiveAddr);
+static int QuickTest(XBram_Config *ConfigPtr);
+
+static XBram Bram0;	/* The Instance of the BRAM Driver */
+static XBram Bram1;	/* The Instance of the BRAM Driver */
+static XGpio input;
+static XGpio output;
+static int InputIrq;
+
+#ifdef INPUT_INTR_ID
+/*
+ * Any change on the handshake inputs only needs to wake the core; the waiting
+ * code re-reads the GPIO itself.
+ */
+static void InputIsr(void *CallBackRef)
+{
+	XGpio_InterruptClear((XGpio *)CallBackRef, XGPIO_IR_CH1_MASK);
+}
+#endif
+
+int BramCmd_Init(void)
+{
+	int Status;
+
+	//////////////////////////////////// BRAM INIT ////////////////////////////////////////////////
+	Status = BramInit(&Bram0, BRAM0_DEVICE_ID);
+	if (Status != XST_SUCCESS) {
+		xil_printf("Bram0 Init Failed\r\n");
+		return XST_FAILURE;
+	}
+	xil_printf("Successfully initialized Bram0\r\n");
+
+	Status = BramInit(&Bram1, BRAM1_DEVICE_ID);
+	if (Status != XST_SUCCESS) {
+		xil_printf("Bram1 Init Failed\r\n");
+		return XST_FAILURE;
+	}
+	xil_printf("Successfully initialized Bram1\r\n");
+
+	///////////////////////////////// INPUT INIT ////////////////////////////////////////////////
+	Status = XGpio_Initialize(&input, INPUT_DEVICE_ID);
+	if (Status != XST_SUCCESS) {
+		xil_printf("XGpio INPUT Initialization failed\r\n");
+		return XST_FAILURE;
+	}
+	xil_printf("Successfully initialized XGpio INPUT\r\n");
+	XGpio_SetDataDirection(&input, INPUT_CHANNEL, 0xF); // input
+
+#ifdef INPUT_INTR_ID
+	if (Intc_Init() == XST_SUCCESS &&
+	    Time_InitWakeup() == XST_SUCCESS &&
+	    Intc_Connect(INPUT_INTR_ID, InputIsr, &input) == XST_SUCCESS) {
+		XGpio_InterruptEnable(&input, XGPIO_IR_CH1_MASK);
+		XGpio_InterruptGlobalEnable(&input);
+		InputIrq = 1;
+		xil_printf("Handshake interrupt enabled\r\n");
+	}
+#endif
+
+	///////////////////////////////// OUTPUT INIT ////////////////////////////////////////////////
+	Status = XGpio_Initialize(&output, OUTPUT_DEVICE_ID);
+	if (Status != XST_SUCCESS) {
+		xil_printf("XGpio OUTPUT Initialization failed\r\n");
+		return XST_FAILURE;
+	}
+	xil_printf("Successfully initialized XGpio OUTPUT\r\n");
+	XGpio_SetDataDirection(&output, OUTPUT_CHANNEL, 0x0); // output
+
+	return XST_SUCCESS;
+}
+
+void BramCmd_WriteCommand(u32 Offset, u32 Data)
+{
+	XBram_WriteReg(BRAM0_BASEADDR, Offset, Data);
+}
+
+u32 BramCmd_ReadResponse(u32 Offset)
+{
+	return XBram_ReadReg(BRAM1_BASEADDR, Offset);
+}
+
+/****************************************************************************/
+/**
+*
+* Write Command1..Command5 to a BRAM0 frame slot with one LDM/STM pair. STM
+* stores in ascending address order, so the FOOTER still lands last.
+*
+* @param	Slot is the frame slot, 0 in single mode, see RING_SLOT().
+* @param	Frame holds CMD_WORDS words.
+*
+* @return	None.
+*
+*****************************************************************************/
+void BramCmd_WriteSlot(u32 Slot, const u32 *Frame)
+{
+	__asm__ __volatile__(
+		"ldmia	%1, {r4, r5, r6, r8, r9}\n\t"
+		"stmia	%0, {r4, r5, r6, r8, r9}\n\t"
+		:
+		: "r" (BRAM0_BASEADDR + Slot * PP_SLOT_STRIDE), "r" (Frame)
+		: "r4", "r5", "r6", "r8", "r9", "memory");
+}
+
+/****************************************************************************/
+/**
+*
+* Read data1..data7 from a BRAM1 response slot in one pass (a 4-word and a
+* 3-word LDM) and keep the low 16 bits of each word.
+*
+* @param	Slot is the response slot, 0 in single mode, see RING_SLOT().
+* @param	Response receives RSP_WORDS words.
+*
+* @return	None.
+*
+*****************************************************************************/
+void BramCmd_ReadSlot(u32 Slot, u32 *Response)
+{
+	u32 Base = BRAM1_BASEADDR + Slot * PP_SLOT_STRIDE;
+	u32 i;
+
+	__asm__ __volatile__(
+		"ldmia	%0, {r4, r5, r6, r8}\n\t"
+		"stmia	%2, {r4, r5, r6, r8}\n\t"
+		"ldmia	%1, {r4, r5, r6}\n\t"
+		"stmia	%3, {r4, r5, r6}\n\t"
+		:
+		: "r" (Base), "r" (Base + 16),
+		  "r" (Response), "r" (Response + 4)
+		: "r4", "r5", "r6", "r8", "memory");
+
+	for (i = 0; i < RSP_WORDS; i++) {
+		Response[i] &= 0xFFFF;
+	}
+}
+
+u32 BramCmd_ReadHandshake(void)
+{
+	return XGpio_DiscreteRead(&input, INPUT_CHANNEL);
+}
+
+void BramCmd_WriteReset(u32 Value)
+{
+	XGpio_DiscreteWrite(&output, OUTPUT_CHANNEL, Value);
+}
+
+/****************************************************************************/
+/**
+*
+* Sleep until Ready(Arg) holds, woken by the handshake GPIO interrupt.
+*
+* Interrupts are masked around the last check and the WFI, so a GPIO edge or
+* the deadline arriving in between leaves the interrupt pending and WFI
+* returns at once instead of sleeping through it.
+*
+* @param	Ready is the condition to wait for.
+* @param	Arg is passed to Ready.
+* @param	Deadline is the Time_Now() value at which to give up.
+*
+* @return	XST_SUCCESS when Ready holds, XST_FAILURE on timeout.
+*
+*****************************************************************************/
+static int WaitFor(WaitCond Ready, u32 Arg, u64 Deadline)
+{
+	int Status = XST_FAILURE;
+
+	if (InputIrq) {
+		Time_ArmWakeup(Deadline);
+	}
+	while (1) {
+		if (Ready(Arg)) {
+			Status = XST_SUCCESS;
+			break;
+		}
+		if (Time_Now() >= Deadline) {
+			break;
+		}
+		if (InputIrq) {
+			Xil_ExceptionDisable();
+			if (!Ready(Arg) && Time_Now() < Deadline) {
+				wfi();
+			}
+			Xil_ExceptionEnable();
+		}
+	}
+	if (InputIrq) {
+		Time_DisarmWakeup();
+	}
+	return Status;
+}
+
+static int BramInit(XBram *InstancePtr, u16 DeviceId)
+{
+	int Status;
+	XBram_Config *ConfigPtr;
+	u64 Start;
+
+	/*
+	 * Lookup configuration data in the device configuration table.
+	 * Use this configuration info down below when initializing this
+	 * driver.
+	 */
+	ConfigPtr = XBram_LookupConfig(DeviceId);
+	if (ConfigPtr == (XBram_Config *) NULL) {
+		return XST_FAILURE;
+	}
+
+	Status = XBram_CfgInitialize(InstancePtr, ConfigPtr,
+				     ConfigPtr->CtrlBaseAddress);
+	if (Status != XST_SUCCESS) {
+		return XST_FAILURE;
+	}
+
+	Start = Time_Now();
+	InitializeECC(ConfigPtr, ConfigPtr->CtrlBaseAddress);
+	xil_printf("  ECC init %d us\r\n", (u32)Time_TicksToUs(Time_Now() - Start));
+
+	Start = Time_Now();
+	if (FIXTURE_BRAM_SELFTEST == BRAM_SELFTEST_FULL) {
+		/*
+		 * Execute the BRAM driver selftest.
+		 */
+		Status = XBram_SelfTest(InstancePtr, 0);
+	}
+	else if (FIXTURE_BRAM_SELFTEST == BRAM_SELFTEST_QUICK) {
+		Status = QuickTest(ConfigPtr);
+	}
+	xil_printf("  self-test %d us\r\n", (u32)Time_TicksToUs(Time_Now() - Start));
+	if (Status != XST_SUCCESS) {
+		return XST_FAILURE;
+	}
+
+	return XST_SUCCESS;
+}
+
+/****************************************************************************/
+/**
+*
+* This function ensures that ECC in the BRAM is initialized if no hardware
+* initialization is available. The ECC bits are initialized by writing every
+* word of the memory, eight words per STM burst: with BRAM_INIT_ZERO the
+* memory is cleared, with BRAM_INIT_PRESERVE each block is read with LDM and
+* written back.
+*
+* @param	ConfigPtr is a reference to a structure containing information
+*		about a specific BRAM device.
+* @param 	EffectiveAddr is the device base address in the virtual memory
+*		address space.
+*
+* @return
+*		None
+*
+* @note		The BRAM size is a multiple of 32 bytes. r7 and r11 are left out
+*		of the register lists as they may be the frame pointer.
+*
+*****************************************************************************/
+static void InitializeECC(XBram_Config *ConfigPtr, u32 EffectiveAddr)
+{
+	u32 Addr;
+
+	if (ConfigPtr->EccPresent &&
+	    ConfigPtr->EccOnOffRegister &&
+	    ConfigPtr->EccOnOffResetValue == 0 &&
+	    ConfigPtr->WriteAccess != 0) {
+		for (Addr = ConfigPtr->MemBaseAddress;
+		     Addr < ConfigPtr->MemHighAddress; Addr += 32) {
+			if (FIXTURE_BRAM_INIT == BRAM_INIT_ZERO) {
+				__asm__ __volatile__(
+					"mov	r4, #0\n\t"
+					"mov	r5, #0\n\t"
+					"mov	r6, #0\n\t"
+					"mov	r8, #0\n\t"
+					"mov	r9, #0\n\t"
+					"mov	r10, #0\n\t"
+					"mov	r12, #0\n\t"
+					"mov	lr, #0\n\t"
+					"stmia	%0, {r4, r5, r6, r8, r9, r10, r12, lr}\n\t"
+					:
+					: "r" (Addr)
+					: "r4", "r5", "r6", "r8", "r9", "r10", "r12", "lr", "memory");
+			}
+			else {
+				__asm__ __volatile__(
+					"ldmia	%0, {r4, r5, r6, r8, r9, r10, r12, lr}\n\t"
+					"stmia	%0, {r4, r5, r6, r8, r9, r10, r12, lr}\n\t"
+					:
+					: "r" (Addr)
+					: "r4", "r5", "r6", "r8", "r9", "r10", "r12", "lr", "memory");
+			}
+		}
+		XBram_WriteReg(EffectiveAddr, XBRAM_ECC_ON_OFF_OFFSET, 1);
+	}
+}
+
+/*
+ * Write, read back and clear two complementary patterns over the first
+ * BRAM_QUICK_TEST_BYTES of the BRAM, the part the fixture actually uses.
+ */
+static int QuickTest(XBram_Config *ConfigPtr)
+{
+	static const u32 Pattern[2] = { 0xA5A5A5A5, 0x5A5A5A5A };
+	u32 Base = ConfigPtr->MemBaseAddress;
+	u32 Offset;
+	u32 p;
+
+	if (ConfigPtr->WriteAccess == 0) {
+		return XST_SUCCESS;
+	}
+	for (p = 0; p < 2; p++) {
+		for (Offset = 0; Offset < BRAM_QUICK_TEST_BYTES; Offset += 4) {
+			XBram_Out32(Base + Offset, Pattern[p] ^ Offset);
+		}
+		for (Offset = 0; Offset < BRAM_QUICK_TEST_BYTES; Offset += 4) {
+			if (XBram_In32(Base + Offset) != (Pattern[p] ^ Offset)) {
+				return XST_FAILURE;
+			}
+		}
+	}
+	for (Offset = 0; Offset < BRAM_QUICK_TEST_BYTES; Offset += 4) {
+		XBram_Out32(Base + Offset, 0);
+	}
+	return XST_SUCCESS;
+}
+
+#else /* FIXTURE_HOST */
+#include "cpld_sim.h"
+
+int BramCmd_Init(void)
+{
+	CpldSim_Init();
+	xil_printf("Successfully initialized simulated CPLD\r\n");
+	return XST_SUCCESS;
+}
+
+void BramCmd_WriteCommand(u32 Offset, u32 Data)
+{
+	CpldSim_WriteBram0(Offset, Data);
+}
+
+u32 BramCmd_ReadResponse(u32 Offset)
+{
+	return CpldSim_ReadBram1(Offset);
+}
+
+void BramCmd_WriteSlot(u32 Slot, const u32 *Frame)
+{
+	u32 i;
+
+	for (i = 0; i < CMD_WORDS; i++) {
+		CpldSim_WriteBram0(Slot * PP_SLOT_STRIDE + i * 4, Frame[i]);
+	}
+}
+
+void BramCmd_ReadSlot(u32 Slot, u32 *Response)
+{
+	u32 i;
+
+	for (i = 0; i < RSP_WORDS; i++) {
+		Response[i] = CpldSim_ReadBram1(Slot * PP_SLOT_STRIDE + i * 4) & 0xFFFF;
+	}
+}
+
+u32 BramCmd_ReadHandshake(void)
+{
+	return CpldSim_ReadGpio();
+}
+
+void BramCmd_WriteReset(u32 Value)
+{
+	CpldSim_WriteReset(Value);
+}
+
+static int WaitFor(WaitCond Ready, u32 Arg, u64 Deadline)
+{
+	while (!Ready(Arg)) {
+		if (Time_Now() >= Deadline) {
+			return XST_FAILURE;
+		}
+	}
+	return XST_SUCCESS;
+}
+
+#endif
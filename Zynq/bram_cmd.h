@@ -1 +1,80 @@
+/******************************************************************************
+* bram_cmd.h: BRAM command/response and handshake GPIO access
+*
+* Thin hardware abstraction over the two AXI BRAM controllers and the two AXI
+* GPIO blocks used by the fixture loop. The Xilinx BSP backend maps straight
+* onto XBram/XGpio; the FIXTURE_HOST backend routes every access to the
+* simulated CPLD in cpld_sim.c.
+*
+* BramCmd_WaitHandshake() sleeps in WFI until the handshake bit rises (AXI GPIO
+* interrupt) or the timeout expires (global timer comparator). Without the
+* GPIO interrupt in the hardware design it polls instead.
+*
+* COMMAND frames are encoded from a FixtureConfig through the field descriptor
+* table in bram_cmd.c. BramCmd_CachedFrame() keeps the frames of all SHnum
+* values of the current configuration, so a cycle only indexes a table.
+*
+* With ECC present, the BRAMs are initialized with 8-word STM bursts;
+* FIXTURE_BRAM_INIT and FIXTURE_BRAM_SELFTEST select what start-up does.
+*
+* BramCmd_WriteFrame()/BramCmd_ReadFrame() move a whole frame with LDM/STM
+* multi-word accesses, which the A9 issues as AXI bursts to the BRAM
+* controllers, instead of one XBram_WriteReg/XBram_ReadReg per word.
+******************************************************************************/
+#ifndef BRAM_CMD_H
+#define BRAM_CMD_H
 
+#include "fixture.h"
+
+/* BRAM start-up in BramCmd_Init(): ECC initialization ... */
+#define BRAM_INIT_PRESERVE		0	/* Read and write back every word */
+#define BRAM_INIT_ZERO			1	/* Zero-fill, contents are don't-care at boot */
+
+#ifndef FIXTURE_BRAM_INIT
+#define FIXTURE_BRAM_INIT		BRAM_INIT_ZERO
+#endif
+
+/* ... and self-test */
+#define BRAM_SELFTEST_SKIP		0
+#define BRAM_SELFTEST_QUICK		1	/* Pattern test of the frame and ring area */
+#define BRAM_SELFTEST_FULL		2	/* XBram_SelfTest(), as the base application */
+
+#ifndef FIXTURE_BRAM_SELFTEST
+#define FIXTURE_BRAM_SELFTEST	BRAM_SELFTEST_QUICK
+#endif
+
+#define BRAM_QUICK_TEST_BYTES	0x500	/* Up to the end of the command ring */
+
+/* CPU clock for the cycle counts of BramCmd_Benchmark(); host builds print
+ * them only when given -DBRAM_CPU_HZ=<host clock> */
+#if !defined(FIXTURE_HOST) && !defined(BRAM_CPU_HZ)
+#include "xparameters.h"
+#define BRAM_CPU_HZ				XPAR_CPU_CORTEXA9_0_CPU_CLK_FREQ_HZ
+#endif
+
+int BramCmd_Init(void);
+
+void BramCmd_BuildFrame(const FixtureConfig *Config, u8 SHnum, u32 *Frame);
+void BramCmd_ParseFrame(const u32 *Frame, FixtureConfig *Config, u8 *SHnum);
+const u32 *BramCmd_CachedFrame(FrameCache *Cache, const FixtureConfig *Config, u8 SHnum);
+void BramCmd_InvalidateCache(FrameCache *Cache);
+
+void BramCmd_WriteCommand(u32 Offset, u32 Data);
+u32 BramCmd_ReadResponse(u32 Offset);
+void BramCmd_WriteFrame(const u32 *Frame);
+void BramCmd_ReadFrame(u32 *Response);
+void BramCmd_WriteSlot(u32 Slot, const u32 *Frame);
+void BramCmd_ReadSlot(u32 Slot, u32 *Response);
+u16 BramCmd_ResponseCount(u32 Slot);
+void BramCmd_SetMode(u32 Mode);
+void BramCmd_RingPost(u32 Head);
+u32 BramCmd_RingTail(void);
+int BramCmd_Benchmark(const u32 *Frame, u32 Iterations);
+
+u32 BramCmd_ReadHandshake(void);
+int BramCmd_WaitHandshake(u32 Mask, u64 Deadline);
+int BramCmd_WaitResponse(u32 Slot, u16 Count, u64 Deadline);
+int BramCmd_WaitRingTail(u32 Tail, u64 Deadline);
+void BramCmd_WriteReset(u32 Value);
+
+#endif
@@ -0,0 +1,94 @@
+/******************************************************************************
+* cmd_queue.c: batched COMMAND frames through the BRAM0/BRAM1 ring
+******************************************************************************/
+#include "cmd_queue.h"
+#include "bram_cmd.h"
+#include "timebase.h"
+
+/*
+ * Switch BRAM0 to ring mode, which also resets the head and tail counts.
+ */
+void CmdQueue_Reset(CmdQueue *Q)
+{
+	BramCmd_SetMode(BRAM_MODE_RING);
+	Q->Head = 0;
+	Q->Tail = 0;
+	Q->Lost = 0;
+}
+
+/*
+ * Read the response to ring frame Index, or zeros if its stamp shows the CPLD
+ * never answered it.
+ */
+static void Collect(CmdQueue *Q, u32 Index, u32 *Response)
+{
+	u32 i;
+
+	BramCmd_ReadSlot(RING_SLOT(Index), Response);
+	if (BramCmd_ResponseCount(RING_SLOT(Index)) != (u16)(Index + 1)) {
+		for (i = 0; i < RSP_WORDS; i++) {
+			Response[i] = 0;
+		}
+		Q->Lost++;
+	}
+}
+
+/****************************************************************************/
+/**
+*
+* Send Count frames through the command ring and collect their responses.
+* The queue must have been reset with CmdQueue_Reset() first.
+*
+* @param	Q is the ring state.
+* @param	Frames holds the COMMAND frames, in sending order.
+* @param	Count is the number of frames.
+* @param	Responses receives one response per frame. Responses of frames
+*		the CPLD did not answer are zero and counted in Q->Lost.
+*
+* @return	XST_SUCCESS, or XST_FAILURE if the CPLD stopped consuming frames
+*		for FIXTURE_READEN_TIMEOUT_US. The ring is reset in that case and
+*		the responses not collected are zero.
+*
+*****************************************************************************/
+int CmdQueue_Run(CmdQueue *Q, const u32 (*Frames)[CMD_WORDS], u32 Count,
+		u32 (*Responses)[RSP_WORDS])
+{
+	u32 Base = Q->Head;
+	u32 End = Q->Head + Count;
+	u32 Tail;
+	u32 Lost;
+	u32 i;
+
+	while (Q->Tail != End) {
+		if (Q->Head != End && Q->Head - Q->Tail < RING_SLOTS) {
+			while (Q->Head != End && Q->Head - Q->Tail < RING_SLOTS) {
+				BramCmd_WriteSlot(RING_SLOT(Q->Head), Frames[Q->Head - Base]);
+				Q->Head++;
+			}
+			BramCmd_RingPost(Q->Head);
+		}
+
+		if (BramCmd_WaitRingTail(Q->Tail + 1,
+				Time_Now() + Time_UsToTicks(FIXTURE_READEN_TIMEOUT_US)) != XST_SUCCESS) {
+			Lost = Q->Lost + (End - Q->Tail);
+			for (; Q->Tail != End; Q->Tail++) {
+				for (i = 0; i < RSP_WORDS; i++) {
+					Responses[Q->Tail - Base][i] = 0;
+				}
+			}
+			CmdQueue_Reset(Q);
+			Q->Lost = Lost;
+			return XST_FAILURE;
+		}
+
+		Tail = BramCmd_RingTail();
+		if (Tail - Q->Tail > Q->Head - Q->Tail) {
+			Tail = Q->Head;		/* Never collect a slot that was not posted */
+		}
+		for (; Q->Tail != Tail; Q->Tail++) {
+			Collect(Q, Q->Tail, Responses[Q->Tail - Base]);
+		}
+	}
+
+	return XST_SUCCESS;
+}
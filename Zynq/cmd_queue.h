@@ -0,0 +1,25 @@
+/******************************************************************************
+* cmd_queue.h: batched COMMAND frames through the BRAM0/BRAM1 ring
+*
+* CmdQueue_Run() posts a whole list of frames to the command ring (see
+* BRAM_MODE_RING in fixture.h), refilling it as the CPLD consumes frames, and
+* collects every response in order. One head write posts as many frames as
+* fit, and one tail read collects all responses posted since the last one, so
+* the PS no longer pays a ReadEn round trip per frame.
+******************************************************************************/
+#ifndef CMD_QUEUE_H
+#define CMD_QUEUE_H
+
+#include "fixture.h"
+
+typedef struct {
+	u32 Head;				/* Frames posted since the ring was reset */
+	u32 Tail;				/* Frames collected */
+	u32 Lost;				/* Frames without a valid response */
+} CmdQueue;
+
+void CmdQueue_Reset(CmdQueue *Q);
+int CmdQueue_Run(CmdQueue *Q, const u32 (*Frames)[CMD_WORDS], u32 Count,
+		u32 (*Responses)[RSP_WORDS]);
+
+#endif
@@ -0,0 +1,373 @@
+/******************************************************************************
+* cpld_sim.c: software model of the CPLD side of the BRAM/GPIO handshake
+******************************************************************************/
+#ifdef FIXTURE_HOST
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "cpld_sim.h"
+
+#define FOOTER_OFFSET		0x10
+#define SIM_QUEUE_DEPTH		64		/* Power of two */
+#define SIM_POSITIONS		8		/* Command1 POS values */
+
+/* State latched by one fixture position */
+typedef struct {
+	u32 Threshold;			/* Latched on ChangeRequest */
+	u32 DryWet;
+	u32 Synchronization;
+	u32 Relays;
+	u32 Inputs;
+} SimBoard;
+
+/* A committed frame waiting for, or in, processing */
+typedef struct {
+	u32 Frame[CMD_WORDS];	/* Copied when the FOOTER is written */
+	u32 RspWord;			/* BRAM1 word index of the response */
+	u32 RingIndex;
+	u64 CommitNs;
+	int Dropped;
+} SimJob;
+
+typedef struct {
+	u32 Bram0[CPLD_SIM_BRAM_WORDS];
+	u32 Bram1[CPLD_SIM_BRAM_WORDS];
+	CpldSim_Config Config;
+
+	u32 Reset;
+	SimBoard Board[SIM_POSITIONS];
+
+	int Pending;			/* Frame written, response not yet posted */
+	u64 DueNs;
+	u32 Gpio;
+	u32 Frames;
+	u32 Rng;
+
+	u32 Mode;				/* BRAM_MODE_* from BRAM0_MODE_OFFSET */
+	SimJob Queue[SIM_QUEUE_DEPTH];
+	u32 QueueHead;
+	u32 QueueCount;
+	u64 LastDoneNs;
+	u32 Responses;			/* Running response count */
+	u32 RingHead;			/* Ring frames committed */
+	u32 RingTail;			/* Ring frames consumed */
+} CpldSim;
+
+static CpldSim Sim;
+
+static const u32 ThresholdCode[4] = {
+	RSP_THRESHOLD_166V,		/* Threshold_166V */
+	RSP_THRESHOLD_84V,		/* Threshold_84V */
+	RSP_THRESHOLD_33V,		/* Threshold_33V */
+	RSP_THRESHOLD_17V,		/* Threshold_17V */
+};
+
+static u32 EnvU32(const char *Name, u32 Default)
+{
+	const char *Value = getenv(Name);
+
+	if (Value == NULL || *Value == '\0') {
+		return Default;
+	}
+	return (u32)strtoul(Value, NULL, 0);
+}
+
+static u32 NextRandom(void)
+{
+	u32 x = Sim.Rng;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	Sim.Rng = x;
+	return x;
+}
+
+static int Chance(u32 Ppm)
+{
+	return Ppm != 0 && (NextRandom() % 1000000) < Ppm;
+}
+
+static void ClearLatched(void)
+{
+	u32 i;
+
+	for (i = 0; i < SIM_POSITIONS; i++) {
+		Sim.Board[i].Threshold = Threshold_166V;
+		Sim.Board[i].DryWet = Wet;
+		Sim.Board[i].Synchronization = NoSynch;
+		Sim.Board[i].Relays = 0;
+		Sim.Board[i].Inputs = 0;
+	}
+}
+
+/*
+ * Decode one COMMAND frame and write the 7-word response to Rsp. Each POS
+ * value addresses a fixture with its own latched state.
+ */
+static void PostResponse(const u32 *Cmd, u32 *Rsp)
+{
+	u32 Header = Cmd[0] & 0xFFFF;
+	u32 Command2 = Cmd[1] & 0xFFFF;
+	u32 Command3 = Cmd[2] & 0xFFFF;
+	u32 Command4 = Cmd[3] & 0xFFFF;
+	u32 Footer = Cmd[4] & 0xFFFF;
+	u32 CommandType = (Command2 >> POS_CommandType) & 0x3;
+	u32 ModId = (Command2 >> POS_ModId) & 0x3;
+	SimBoard *B = &Sim.Board[(Header >> POS_Pos) & 0x7];
+	u32 Status = 0;
+
+	if ((Header & 0xFF00) != (FRAME_HEADER & 0xFF00) ||
+	    Footer != FRAME_FOOTER ||
+	    Command4 != (~Command3 & 0xFFFF) ||
+	    Chance(Sim.Config.FrameErrorPpm)) {
+		Status |= RSP_FRAME_ERROR;
+	}
+	if (ModId != Mod_Id || CommandType == 0x3) {
+		Status |= RSP_COMMAND_ERROR_BIT;
+	}
+
+	if (Sim.Reset == RESET_ASSERT) {
+		ClearLatched();
+		Status |= RSP_12V_RLY_OFF;
+	}
+	else if (CommandType == ChangeRequest && Status == 0) {
+		B->Threshold = (Command2 >> POS_Threshold) & 0x3;
+		B->DryWet = (Command2 >> POS_DryWet) & 0x1;
+		B->Synchronization = (Command2 >> POS_Synch) & 0x1;
+		B->Relays = Command3 & RSP_RELAY_MASK;
+	}
+
+	/* Contact inputs loop back from the relays, plus optional noise */
+	B->Inputs = (B->Inputs & ~RSP_RELAY_MASK) | B->Relays;
+	if (Chance(Sim.Config.InputNoisePpm)) {
+		B->Inputs ^= 1u << (NextRandom() % 7);
+	}
+
+	if (B->Relays != 0 && Chance(Sim.Config.CoilErrorPpm)) {
+		Status |= RSP_COIL_ERROR;
+	}
+
+	Status |= ThresholdCode[B->Threshold];
+	if (B->DryWet == Dry) Status |= RSP_DRY;
+	if (B->Synchronization == Synch) Status |= RSP_SYNCH;
+	Status |= Command2 & 0xFF;
+
+	Rsp[0] = Header;
+	Rsp[1] = Status;
+	if (CommandType == CPLDRev) {
+		Rsp[2] = CPLD_SIM_REV_MMDD;
+		Rsp[3] = CPLD_SIM_REV_YYRR;
+	}
+	else {
+		Rsp[2] = B->Relays;
+		Rsp[3] = B->Inputs & RSP_INPUT_MASK;
+	}
+	Rsp[4] = Sim.Frames & 0xFFFF;
+	Rsp[5] = 0;
+	Rsp[6] = 0;
+
+	Sim.Frames++;
+}
+
+/*
+ * Queued modes: serve committed frames in order, each taking TurnaroundNs
+ * after the later of its commit and the end of the previous one.
+ */
+static void AdvanceQueue(u64 Now)
+{
+	SimJob *Job;
+	u64 Start;
+	u64 Due;
+	u32 Waiting;
+
+	while (Sim.QueueCount != 0) {
+		Job = &Sim.Queue[Sim.QueueHead];
+		Start = Job->CommitNs > Sim.LastDoneNs ? Job->CommitNs : Sim.LastDoneNs;
+		Due = Start + Sim.Config.TurnaroundNs;
+		if (Now < Due) {
+			break;
+		}
+		if (Sim.Mode == BRAM_MODE_RING) {
+			Sim.RingTail++;
+			if (!Job->Dropped) {
+				PostResponse(Job->Frame, &Sim.Bram1[Job->RspWord]);
+				Sim.Bram1[Job->RspWord + (PP_DONE_OFFSET >> 2)] = Sim.RingTail & 0xFFFF;
+			}
+			Sim.Bram1[RING_TAIL_OFFSET >> 2] = Sim.RingTail;
+			Sim.Gpio ^= HS_READ_EN;
+		}
+		else if (!Job->Dropped) {
+			PostResponse(Job->Frame, &Sim.Bram1[Job->RspWord]);
+			Sim.Responses++;
+			Sim.Bram1[Job->RspWord + (PP_DONE_OFFSET >> 2)] = Sim.Responses & 0xFFFF;
+			Sim.Gpio ^= HS_READ_EN;
+		}
+		Sim.LastDoneNs = Due;
+		Sim.QueueHead = (Sim.QueueHead + 1) & (SIM_QUEUE_DEPTH - 1);
+		Sim.QueueCount--;
+	}
+
+	/* The head frame is latched; the ones behind it still occupy their slot */
+	Waiting = Sim.QueueCount ? Sim.QueueCount - 1 : 0;
+	if (Waiting < (Sim.Mode == BRAM_MODE_RING ? RING_SLOTS : PP_SLOTS)) Sim.Gpio |= HS_WRITE_EN;
+	else Sim.Gpio &= ~HS_WRITE_EN;
+}
+
+static void Commit(u32 CmdWord, u32 RspWord)
+{
+	SimJob *Job;
+
+	if (Sim.QueueCount == SIM_QUEUE_DEPTH) {
+		return;				/* Overwritten before it was served */
+	}
+	Job = &Sim.Queue[(Sim.QueueHead + Sim.QueueCount) & (SIM_QUEUE_DEPTH - 1)];
+	memcpy(Job->Frame, &Sim.Bram0[CmdWord], sizeof(Job->Frame));
+	Job->RspWord = RspWord;
+	Job->CommitNs = CpldSim_NowNs();
+	Job->Dropped = Chance(Sim.Config.DropPpm);
+	Sim.QueueCount++;
+	AdvanceQueue(Job->CommitNs);
+}
+
+/*
+ * Ring mode: commit the frames between the last head and the new one.
+ */
+static void PostRing(u32 Head)
+{
+	u32 Word;
+
+	if (Head - Sim.RingHead > RING_SLOTS) {
+		Sim.RingHead = Head - RING_SLOTS;	/* Older ones were overwritten */
+	}
+	while (Sim.RingHead != Head) {
+		Word = (RING_SLOT(Sim.RingHead) * PP_SLOT_STRIDE) >> 2;
+		Commit(Word, Word);
+		Sim.RingHead++;
+	}
+}
+
+static void ResetRing(void)
+{
+	u32 i;
+
+	Sim.RingHead = 0;
+	Sim.RingTail = 0;
+	Sim.Bram1[RING_TAIL_OFFSET >> 2] = 0;
+	for (i = 0; i < RING_SLOTS; i++) {
+		Sim.Bram1[((RING_SLOT(i) * PP_SLOT_STRIDE) >> 2) + (PP_DONE_OFFSET >> 2)] = 0;
+	}
+}
+
+static void Advance(void)
+{
+	if (Sim.Mode != BRAM_MODE_SINGLE) {
+		AdvanceQueue(CpldSim_NowNs());
+		return;
+	}
+	if (Sim.Pending && CpldSim_NowNs() >= Sim.DueNs) {
+		PostResponse(Sim.Bram0, Sim.Bram1);
+		Sim.Pending = 0;
+		Sim.Gpio |= HS_READ_EN | HS_WRITE_EN;
+	}
+}
+
+void CpldSim_Init(void)
+{
+	CpldSim_Config Config;
+
+	memset(&Sim, 0, sizeof(Sim));
+	ClearLatched();
+	Sim.Gpio = HS_WRITE_EN;
+
+	Config.TurnaroundNs = EnvU32("CPLD_SIM_TURNAROUND_NS", 20000);
+	Config.FrameErrorPpm = EnvU32("CPLD_SIM_FRAME_ERR_PPM", 0);
+	Config.CoilErrorPpm = EnvU32("CPLD_SIM_COIL_ERR_PPM", 0);
+	Config.InputNoisePpm = EnvU32("CPLD_SIM_INPUT_NOISE_PPM", 0);
+	Config.DropPpm = EnvU32("CPLD_SIM_DROP_PPM", 0);
+	Config.Seed = EnvU32("CPLD_SIM_SEED", 1);
+	CpldSim_Configure(&Config);
+}
+
+void CpldSim_Configure(const CpldSim_Config *ConfigPtr)
+{
+	Sim.Config = *ConfigPtr;
+	Sim.Rng = ConfigPtr->Seed ? ConfigPtr->Seed : 1;
+}
+
+void CpldSim_GetConfig(CpldSim_Config *ConfigPtr)
+{
+	*ConfigPtr = Sim.Config;
+}
+
+void CpldSim_WriteBram0(u32 Offset, u32 Data)
+{
+	Sim.Bram0[(Offset >> 2) % CPLD_SIM_BRAM_WORDS] = Data;
+
+	if (Offset == BRAM0_MODE_OFFSET) {
+		Sim.Mode = Data;
+		Sim.Pending = 0;
+		Sim.QueueCount = 0;
+		Sim.Gpio = HS_WRITE_EN;
+		ResetRing();
+		return;
+	}
+	if (Sim.Mode == BRAM_MODE_RING) {
+		if (Offset == RING_HEAD_OFFSET) {
+			PostRing(Data);
+		}
+		return;
+	}
+	if (Sim.Mode == BRAM_MODE_PINGPONG) {
+		if (Offset == FOOTER_OFFSET || Offset == PP_SLOT_STRIDE + FOOTER_OFFSET) {
+			Commit((Offset - FOOTER_OFFSET) >> 2, (Offset - FOOTER_OFFSET) >> 2);
+		}
+		return;
+	}
+
+	if (Offset == FOOTER_OFFSET) {
+		Sim.Gpio &= ~(HS_READ_EN | HS_WRITE_EN);
+		Sim.Pending = !Chance(Sim.Config.DropPpm);
+		if (!Sim.Pending) {
+			Sim.Gpio |= HS_WRITE_EN;	/* Lost frame: ready again, no response */
+		}
+		Sim.DueNs = CpldSim_NowNs() + Sim.Config.TurnaroundNs;
+	}
+}
+
+u32 CpldSim_ReadBram1(u32 Offset)
+{
+	Advance();
+	return Sim.Bram1[(Offset >> 2) % CPLD_SIM_BRAM_WORDS];
+}
+
+u32 CpldSim_ReadGpio(void)
+{
+	Advance();
+	return Sim.Gpio;
+}
+
+void CpldSim_WriteReset(u32 Value)
+{
+	Sim.Reset = Value & RESET_RELEASE;
+	if (Sim.Reset == RESET_ASSERT) {
+		ClearLatched();
+	}
+}
+
+u64 CpldSim_NowNs(void)
+{
+	struct timespec Now;
+
+	clock_gettime(CLOCK_MONOTONIC, &Now);
+	return (u64)Now.tv_sec * 1000000000ull + (u64)Now.tv_nsec;
+}
+
+u32 CpldSim_FrameCount(void)
+{
+	return Sim.Frames;
+}
+
+#endif /* FIXTURE_HOST */
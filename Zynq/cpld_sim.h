@@ -0,0 +1,49 @@
+/******************************************************************************
+* cpld_sim.h: software model of the CPLD side of the BRAM/GPIO handshake
+*
+* Used by the FIXTURE_HOST backend of bram_cmd.c. Writing the FOOTER word of a
+* COMMAND frame to BRAM0 starts a simulated turnaround; once it has elapsed
+* the response is placed in BRAM1 and ReadEn is raised on the next GPIO read.
+* In ping-pong and ring mode (BRAM0_MODE_OFFSET, see fixture.h) committed
+* frames are queued and served back to back in commit order.
+*
+* The model can be tuned at start-up through environment variables:
+*
+*   CPLD_SIM_TURNAROUND_NS   write-to-ReadEn latency (default 20000)
+*   CPLD_SIM_FRAME_ERR_PPM   injected FRAME ERROR rate, parts per million
+*   CPLD_SIM_COIL_ERR_PPM    injected COIL ERROR rate, parts per million
+*   CPLD_SIM_INPUT_NOISE_PPM random contact input toggle rate per frame
+*   CPLD_SIM_DROP_PPM        frames never answered (ReadEn stays low)
+*   CPLD_SIM_SEED            random seed for the injected faults
+******************************************************************************/
+#ifndef CPLD_SIM_H
+#define CPLD_SIM_H
+
+#include "fixture.h"
+
+#define CPLD_SIM_BRAM_WORDS		2048
+#define CPLD_SIM_REV_MMDD		0x1017
+#define CPLD_SIM_REV_YYRR		0x2601
+
+typedef struct {
+	u32 TurnaroundNs;
+	u32 FrameErrorPpm;
+	u32 CoilErrorPpm;
+	u32 InputNoisePpm;
+	u32 DropPpm;
+	u32 Seed;
+} CpldSim_Config;
+
+void CpldSim_Init(void);
+void CpldSim_Configure(const CpldSim_Config *ConfigPtr);
+void CpldSim_GetConfig(CpldSim_Config *ConfigPtr);
+
+void CpldSim_WriteBram0(u32 Offset, u32 Data);
+u32 CpldSim_ReadBram1(u32 Offset);
+u32 CpldSim_ReadGpio(void);
+void CpldSim_WriteReset(u32 Value);
+
+u64 CpldSim_NowNs(void);
+u32 CpldSim_FrameCount(void);
+
+#endif
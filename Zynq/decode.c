@@ -0,0 +1,215 @@
+/******************************************************************************
+* decode.c: batch decode of response tables into per-field arrays
+******************************************************************************/
+#include <string.h>
+#include "decode.h"
+
+#if FIXTURE_DECODE_NEON
+#include <arm_neon.h>
+
+#define DECODE_LANES		16
+#define DECODE_FLUSH		255		/* Steps before a byte lane counter can overflow */
+#endif
+
+/* Decode response n into Out and add it to Counts */
+static void DecodeOne(const u32 *Rsp, u32 n, const DecodeFields *Out, DecodeCounts *Counts)
+{
+	u32 Timeout = (Rsp[0] & 0xFFFF) == 0;
+	u32 Flags = ((Rsp[1] >> 8) & DECODE_DATA2_FLAGS) | (Timeout << DECODE_TIMEOUT);
+	u32 Threshold = (Rsp[1] & RSP_THRESHOLD_MASK) >> 10;
+	u32 Relays = Rsp[2] & RSP_RELAY_MASK;
+	u32 Inputs = Rsp[3] & RSP_INPUT_MASK;
+	u32 b;
+
+	if (Out != NULL) {
+		Out->Flags[n] = (u8)Flags;
+		Out->Threshold[n] = (u8)Threshold;
+		Out->Relays[n] = (u8)Relays;
+		Out->Inputs[n] = (u8)Inputs;
+	}
+	for (b = 0; b < DECODE_FLAG_BITS; b++) {
+		Counts->Flag[b] += (Flags >> b) & 1;
+	}
+	if (!Timeout) {
+		Counts->Threshold[Threshold]++;
+	}
+	for (b = 0; b < DECODE_RELAY_BITS; b++) {
+		Counts->Relay[b] += (Relays >> b) & 1;
+	}
+	for (b = 0; b < DECODE_INPUT_BITS; b++) {
+		Counts->Input[b] += (Inputs >> b) & 1;
+	}
+}
+
+/*
+ * Plain C decode, one response at a time; see Decode_Batch().
+ */
+void Decode_BatchScalar(const u32 (*Rsp)[RSP_WORDS], u32 Count, const DecodeFields *Out,
+		DecodeCounts *Counts)
+{
+	u32 n;
+
+	memset(Counts, 0, sizeof(*Counts));
+	for (n = 0; n < Count; n++) {
+		DecodeOne(Rsp[n], n, Out, Counts);
+	}
+	Counts->Responses = Count;
+}
+
+#if FIXTURE_DECODE_NEON
+
+/* Byte lane counters, in DecodeCounts order from Flag[0] */
+#define DECODE_COUNTERS		(DECODE_FLAG_BITS + DECODE_THRESHOLDS + DECODE_RELAY_BITS + DECODE_INPUT_BITS)
+
+/*
+ * data1..data4 of four responses, transposed so that lane r of W[i] is
+ * data(i + 1) of response r, narrowed to the 16 bits the CPLD drives.
+ */
+static inline void Load4(const u32 (*Rsp)[RSP_WORDS], uint16x4_t *W)
+{
+	uint32x4x2_t t01 = vtrnq_u32(vld1q_u32(Rsp[0]), vld1q_u32(Rsp[1]));
+	uint32x4x2_t t23 = vtrnq_u32(vld1q_u32(Rsp[2]), vld1q_u32(Rsp[3]));
+
+	W[0] = vmovn_u32(vcombine_u32(vget_low_u32(t01.val[0]), vget_low_u32(t23.val[0])));
+	W[1] = vmovn_u32(vcombine_u32(vget_low_u32(t01.val[1]), vget_low_u32(t23.val[1])));
+	W[2] = vmovn_u32(vcombine_u32(vget_high_u32(t01.val[0]), vget_high_u32(t23.val[0])));
+	W[3] = vmovn_u32(vcombine_u32(vget_high_u32(t01.val[1]), vget_high_u32(t23.val[1])));
+}
+
+/* One field of eight responses as bytes: word i of Load4() groups g and g + 1 */
+static inline uint16x8_t Word8(uint16x4_t (*W)[4], u32 g, u32 i)
+{
+	return vcombine_u16(W[g][i], W[g + 1][i]);
+}
+
+/* Add the byte lane counters to Total and clear them */
+static void Flush(uint8x16_t *Acc, u32 *Total)
+{
+	uint64x2_t Sum;
+	u32 k;
+
+	for (k = 0; k < DECODE_COUNTERS; k++) {
+		Sum = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(Acc[k])));
+		Total[k] += (u32)(vgetq_lane_u64(Sum, 0) + vgetq_lane_u64(Sum, 1));
+		Acc[k] = vdupq_n_u8(0);
+	}
+}
+
+/* Count the lanes of V with bit b set into Acc[0..Bits-1] */
+static inline void CountBits(uint8x16_t *Acc, uint8x16_t V, u32 Bits)
+{
+	u32 b;
+
+	for (b = 0; b < Bits; b++) {
+		Acc[b] = vsubq_u8(Acc[b], vtstq_u8(V, vdupq_n_u8((u8)(1u << b))));
+	}
+}
+
+/* Spread the totals, in counter order, over the fields of Counts */
+static void Store(const u32 *Total, DecodeCounts *Counts)
+{
+	u32 k;
+
+	for (k = 0; k < DECODE_FLAG_BITS; k++) {
+		Counts->Flag[k] = *Total++;
+	}
+	for (k = 0; k < DECODE_THRESHOLDS; k++) {
+		Counts->Threshold[k] = *Total++;
+	}
+	for (k = 0; k < DECODE_RELAY_BITS; k++) {
+		Counts->Relay[k] = *Total++;
+	}
+	for (k = 0; k < DECODE_INPUT_BITS; k++) {
+		Counts->Input[k] = *Total++;
+	}
+}
+
+#endif /* FIXTURE_DECODE_NEON */
+
+/****************************************************************************/
+/**
+*
+* Decode Count responses into per-field byte arrays and per-field counts,
+* see decode.h for the fields.
+*
+* @param	Rsp points to Count responses of RSP_WORDS words.
+* @param	Count is the number of responses.
+* @param	Out receives Count bytes per field, or is NULL to only count.
+* @param	Counts receives the totals over the batch.
+*
+* @return	None.
+*
+*****************************************************************************/
+void Decode_Batch(const u32 (*Rsp)[RSP_WORDS], u32 Count, const DecodeFields *Out,
+		DecodeCounts *Counts)
+{
+#if FIXTURE_DECODE_NEON
+	u32 Total[DECODE_COUNTERS];
+	uint8x16_t Acc[DECODE_COUNTERS];
+	uint16x4_t W[DECODE_LANES / 4][4];
+	uint8x16_t Flags;
+	uint8x16_t Timeout;
+	uint8x16_t Answered;
+	uint8x16_t Threshold;
+	uint8x16_t Relays;
+	uint8x16_t Inputs;
+	u32 Steps = 0;
+	u32 n;
+	u32 g;
+	u32 k;
+
+	for (k = 0; k < DECODE_COUNTERS; k++) {
+		Total[k] = 0;
+		Acc[k] = vdupq_n_u8(0);
+	}
+
+	for (n = 0; n + DECODE_LANES <= Count; n += DECODE_LANES) {
+		for (g = 0; g < DECODE_LANES / 4; g++) {
+			Load4(Rsp + n + 4 * g, W[g]);
+		}
+
+		/* Flags and threshold from the high byte of data2 */
+		Flags = vcombine_u8(vshrn_n_u16(Word8(W, 0, 1), 8), vshrn_n_u16(Word8(W, 2, 1), 8));
+		Threshold = vandq_u8(vshrq_n_u8(Flags, 2), vdupq_n_u8(0x3));
+		Timeout = vcombine_u8(vmovn_u16(vceqq_u16(Word8(W, 0, 0), vdupq_n_u16(0))),
+				vmovn_u16(vceqq_u16(Word8(W, 2, 0), vdupq_n_u16(0))));
+		Flags = vorrq_u8(vandq_u8(Flags, vdupq_n_u8(DECODE_DATA2_FLAGS)),
+				vandq_u8(Timeout, vdupq_n_u8(1u << DECODE_TIMEOUT)));
+		Relays = vandq_u8(vcombine_u8(vmovn_u16(Word8(W, 0, 2)), vmovn_u16(Word8(W, 2, 2))),
+				vdupq_n_u8(RSP_RELAY_MASK));
+		Inputs = vandq_u8(vcombine_u8(vmovn_u16(Word8(W, 0, 3)), vmovn_u16(Word8(W, 2, 3))),
+				vdupq_n_u8(RSP_INPUT_MASK));
+
+		if (Out != NULL) {
+			vst1q_u8(Out->Flags + n, Flags);
+			vst1q_u8(Out->Threshold + n, Threshold);
+			vst1q_u8(Out->Relays + n, Relays);
+			vst1q_u8(Out->Inputs + n, Inputs);
+		}
+
+		CountBits(Acc, Flags, DECODE_FLAG_BITS);
+		Answered = vmvnq_u8(Timeout);
+		for (k = 0; k < DECODE_THRESHOLDS; k++) {
+			Acc[DECODE_FLAG_BITS + k] = vsubq_u8(Acc[DECODE_FLAG_BITS + k],
+					vandq_u8(vceqq_u8(Threshold, vdupq_n_u8((u8)k)), Answered));
+		}
+		CountBits(Acc + DECODE_FLAG_BITS + DECODE_THRESHOLDS, Relays, DECODE_RELAY_BITS);
+		CountBits(Acc + DECODE_FLAG_BITS + DECODE_THRESHOLDS + DECODE_RELAY_BITS, Inputs,
+				DECODE_INPUT_BITS);
+
+		if (++Steps == DECODE_FLUSH) {
+			Flush(Acc, Total);
+			Steps = 0;
+		}
+	}
+	Flush(Acc, Total);
+	Store(Total, Counts);
+
+	for (; n < Count; n++) {
+		DecodeOne(Rsp[n], n, Out, Counts);
+	}
+	Counts->Responses = Count;
+#else
+	Decode_BatchScalar(Rsp, Count, Out, Counts);
+#endif
+}
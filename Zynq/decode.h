@@ -0,0 +1,69 @@
+/******************************************************************************
+* decode.h: batch decode of response tables into per-field arrays
+*
+* Decode_Batch() takes N data1..data7 responses collected in bulk (a sweep
+* table, a command ring batch, a replayed session) and, in one pass, writes
+* one byte per response into each field array and counts each field:
+*
+*   Flags      DECODE_ bit numbers: data2 bits 15:8 with the threshold code replaced
+*              by DECODE_TIMEOUT (no HEADER echo in data1)
+*   Threshold  data2 bits 11:10, RSP_THRESHOLD_* >> 10
+*   Relays     data3 bits 4:0, RELAY_AA..RELAY_CC
+*   Inputs     data4 bits 6:0, Input_1..Input_7
+*
+* Built with NEON available (-mfpu=neon on the A9) sixteen responses are
+* decoded per step: four data1..data4 loads per four responses, a 4x4
+* transpose, narrowing to bytes and per-bit counts in byte lanes.
+* Decode_BatchScalar() is the plain C version, used for the remainder and on
+* hosts without NEON; both give the same results.
+******************************************************************************/
+#ifndef DECODE_H
+#define DECODE_H
+
+#include "fixture.h"
+
+#ifndef FIXTURE_DECODE_NEON
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define FIXTURE_DECODE_NEON		1
+#else
+#define FIXTURE_DECODE_NEON		0
+#endif
+#endif
+
+/* Bit numbers in Flags and DecodeCounts.Flag: bit b of data2 >> 8, except DECODE_TIMEOUT */
+#define DECODE_SYNC			0
+#define DECODE_DRY			1
+#define DECODE_TIMEOUT		2
+#define DECODE_COIL			4
+#define DECODE_12V_OFF		5
+#define DECODE_COMMAND		6
+#define DECODE_FRAME		7
+#define DECODE_DATA2_FLAGS	0xF3	/* data2 >> 8 without the threshold code */
+
+#define DECODE_FLAG_BITS	8
+#define DECODE_THRESHOLDS	4
+#define DECODE_RELAY_BITS	5
+#define DECODE_INPUT_BITS	7
+
+/* Structure-of-arrays output, N bytes each */
+typedef struct {
+	u8 *Flags;
+	u8 *Threshold;
+	u8 *Relays;
+	u8 *Inputs;
+} DecodeFields;
+
+typedef struct {
+	u32 Responses;
+	u32 Flag[DECODE_FLAG_BITS];		/* Responses with flag bit b set */
+	u32 Threshold[DECODE_THRESHOLDS];	/* Answered responses per threshold code */
+	u32 Relay[DECODE_RELAY_BITS];	/* Responses with relay bit b read back set */
+	u32 Input[DECODE_INPUT_BITS];	/* Responses with input b set */
+} DecodeCounts;
+
+void Decode_Batch(const u32 (*Rsp)[RSP_WORDS], u32 Count, const DecodeFields *Out,
+		DecodeCounts *Counts);
+void Decode_BatchScalar(const u32 (*Rsp)[RSP_WORDS], u32 Count, const DecodeFields *Out,
+		DecodeCounts *Counts);
+
+#endif
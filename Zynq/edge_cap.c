@@ -0,0 +1,238 @@
+/******************************************************************************
+* edge_cap.c: contact input edge capture for bounce analysis
+******************************************************************************/
+#include <string.h>
+#include "edge_cap.h"
+#include "bram_cmd.h"
+#include "fmt.h"
+#include "uart_cli.h"
+#include "timebase.h"
+
+#define EDGE_RING_MASK		(EDGE_RING_SIZE - 1)
+#define EDGE_LINE_MAX		120		/* Longest edge line */
+#define EDGE_DRAIN_US		10000	/* Drain at least this often */
+#define EDGE_NO_PULSE		0xFFFFFFFF
+
+static EdgeRing Ring;
+static EdgeCapSummary Summary;
+static u32 LastEdgeUs[EDGE_INPUTS];		/* Consumer: previous edge per input */
+static u8 Seen;							/* Consumer: inputs with a previous edge */
+static FmtBuf Out;
+
+/*
+ * Producer side: append E, or count it as dropped if the ring is full.
+ */
+int EdgeRing_Push(EdgeRing *R, const EdgeEvent *E)
+{
+	u32 Head = R->Head;
+
+	if (Head - R->Tail == EDGE_RING_SIZE) {
+		R->Dropped++;
+		return XST_FAILURE;
+	}
+	R->Event[Head & EDGE_RING_MASK] = *E;
+	EDGE_BARRIER();
+	R->Head = Head + 1;
+	return XST_SUCCESS;
+}
+
+/*
+ * Consumer side: take the oldest event, XST_NO_DATA if there is none.
+ */
+int EdgeRing_Pop(EdgeRing *R, EdgeEvent *E)
+{
+	u32 Tail = R->Tail;
+
+	if (Tail == R->Head) {
+		return XST_NO_DATA;
+	}
+	EDGE_BARRIER();
+	*E = R->Event[Tail & EDGE_RING_MASK];
+	EDGE_BARRIER();
+	R->Tail = Tail + 1;
+	return XST_SUCCESS;
+}
+
+static void FormatEdge(FmtBuf *B, const EdgeEvent *E)
+{
+	u32 Changed = (u32)(E->Old ^ E->New);
+	u32 Width;
+	u32 i;
+
+	Fmt_Lit(B, "EDGE ");
+	Fmt_Dec(B, E->AtUs);
+	Fmt_Lit(B, " us 0x");
+	Fmt_Hex4(B, E->Old);
+	Fmt_Lit(B, " -> 0x");
+	Fmt_Hex4(B, E->New);
+	for (i = 0; i < EDGE_INPUTS; i++) {
+		if (!(Changed & (1u << i))) {
+			continue;
+		}
+		Fmt_Lit(B, " in");
+		Fmt_Dec(B, i + 1);
+		if (E->New & (1u << i)) {
+			Fmt_Lit(B, " on");
+		}
+		else Fmt_Lit(B, " off");
+		if (Seen & (1u << i)) {
+			Width = E->AtUs - LastEdgeUs[i];
+			Fmt_Lit(B, " +");
+			Fmt_Dec(B, Width);
+			if (Width < Summary.MinPulseUs[i]) Summary.MinPulseUs[i] = Width;
+		}
+		LastEdgeUs[i] = E->AtUs;
+		Seen |= (u8)(1u << i);
+	}
+	Fmt_Lit(B, "\r\n");
+}
+
+/*
+ * Consumer: format queued edges while the UART TX ring can take them, or all
+ * of them, waiting for the UART, if Wait is set.
+ */
+static void Drain(int Wait)
+{
+	EdgeEvent E;
+
+	while (Wait || Out.Len + EDGE_LINE_MAX <= UartCli_TxFree()) {
+		if (Out.Len > FMT_BUF_SIZE - EDGE_LINE_MAX) {
+			if (!Wait) break;
+			Fmt_Flush(&Out);
+		}
+		if (EdgeRing_Pop(&Ring, &E) != XST_SUCCESS) {
+			break;
+		}
+		FormatEdge(&Out, &E);
+	}
+	if (Out.Len != 0) {
+		if (Wait) {
+			Fmt_Flush(&Out);
+		}
+		else {
+			UartCli_Send((const u8 *)Out.Buf, Out.Len);
+			Out.Len = 0;
+		}
+	}
+}
+
+/****************************************************************************/
+/**
+*
+* Sample data4 with back-to-back DataUpdate frames for DurationMs and print
+* every change of the contact inputs as it is drained. BRAM0 is left in
+* single-frame mode.
+*
+* @param	Config is the commanded state; the frames are DataUpdate frames
+*		of it, so the relays are not operated.
+* @param	SHnum is the Sample and Hold number of every frame.
+* @param	DurationMs is the capture time.
+*
+* @return	XST_SUCCESS, or XST_FAILURE if any edge was dropped.
+*
+*****************************************************************************/
+int EdgeCap_Run(const FixtureConfig *Config, u8 SHnum, u32 DurationMs)
+{
+	FixtureConfig Poll = *Config;
+	u32 Frame[CMD_WORDS];
+	EdgeEvent E;
+	u64 Start;
+	u64 End;
+	u64 NextDrain;
+	u64 Now;
+	u64 Last;
+	u32 Gap;
+	u8 Prev;
+	u8 Inputs;
+	u32 i;
+
+	memset(&Summary, 0, sizeof(Summary));
+	for (i = 0; i < EDGE_INPUTS; i++) {
+		Summary.MinPulseUs[i] = EDGE_NO_PULSE;
+	}
+	Ring.Head = Ring.Tail = Ring.Dropped = 0;
+	Seen = 0;
+
+	Poll.CommandType = DataUpdate;
+	BramCmd_BuildFrame(&Poll, SHnum, Frame);
+	BramCmd_SetMode(BRAM_MODE_SINGLE);
+
+	Start = Time_Now();
+	End = Start + Time_UsToTicks((u64)DurationMs * 1000);
+	NextDrain = Start + Time_UsToTicks(EDGE_DRAIN_US);
+	Last = Start;
+	Prev = 0;
+	while (1) {
+		BramCmd_WriteFrame(Frame);
+		if (BramCmd_WaitHandshake(HS_READ_EN,
+				Time_Now() + Time_UsToTicks(FIXTURE_READEN_TIMEOUT_US)) != XST_SUCCESS) {
+			Summary.Timeouts++;
+			if (Time_Now() >= End) break;
+			continue;
+		}
+		Now = Time_Now();
+		Inputs = (u8)(BramCmd_ReadResponse(12) & RSP_INPUT_MASK);	/* data4 */
+
+		if (Summary.Samples++ != 0 && (Inputs ^ Prev) != 0) {
+			E.AtUs = (u32)Time_TicksToUs(Now - Start);
+			E.Old = Prev;
+			E.New = Inputs;
+			if (EdgeRing_Push(&Ring, &E) == XST_SUCCESS) {
+				Summary.Edges++;
+			}
+		}
+		Prev = Inputs;
+		Gap = (u32)Time_TicksToUs(Now - Last);
+		if (Gap > Summary.MaxGapUs) Summary.MaxGapUs = Gap;
+		Last = Now;
+
+		if (Now >= End) {
+			break;
+		}
+		if (Ring.Head - Ring.Tail >= EDGE_RING_SIZE / 2 || Now >= NextDrain) {
+			Drain(0);
+			NextDrain = Time_Now() + Time_UsToTicks(EDGE_DRAIN_US);
+			if (UartCli_TryRecvCancel()) {
+				break;
+			}
+		}
+	}
+	Summary.ElapsedUs = (u32)Time_TicksToUs(Time_Now() - Start);
+	Drain(1);
+
+	return Ring.Dropped ? XST_FAILURE : XST_SUCCESS;
+}
+
+void EdgeCap_PrintSummary(void)
+{
+	u32 i;
+
+	Fmt_Lit(&Out, "EDGE CAPTURE: ");
+	Fmt_Dec(&Out, Summary.Samples);
+	Fmt_Lit(&Out, " samples in ");
+	Fmt_Dec(&Out, Summary.ElapsedUs);
+	Fmt_Lit(&Out, " us (every ");
+	Fmt_Dec(&Out, Summary.Samples ? Summary.ElapsedUs / Summary.Samples : 0);
+	Fmt_Lit(&Out, " us, max gap ");
+	Fmt_Dec(&Out, Summary.MaxGapUs);
+	Fmt_Lit(&Out, " us), ");
+	Fmt_Dec(&Out, Summary.Edges);
+	Fmt_Lit(&Out, " edges, ");
+	Fmt_Dec(&Out, Ring.Dropped);
+	Fmt_Lit(&Out, " dropped, ");
+	Fmt_Dec(&Out, Summary.Timeouts);
+	Fmt_Lit(&Out, " timeouts\r\n  shortest pulse us:");
+	for (i = 0; i < EDGE_INPUTS; i++) {
+		Fmt_Lit(&Out, " in");
+		Fmt_Dec(&Out, i + 1);
+		if (Summary.MinPulseUs[i] == EDGE_NO_PULSE) {
+			Fmt_Lit(&Out, " -");
+		}
+		else {
+			Fmt_Lit(&Out, " ");
+			Fmt_Dec(&Out, Summary.MinPulseUs[i]);
+		}
+	}
+	Fmt_Lit(&Out, "\r\n");
+	Fmt_Flush(&Out);
+}
@@ -0,0 +1,57 @@
+/******************************************************************************
+* edge_cap.h: contact input edge capture for bounce analysis
+*
+* EdgeCap_Run() sends DataUpdate frames back to back, as fast as the
+* handshake allows, and reads only data4 of each response. A sample that
+* differs from the previous one (XOR) appends an edge event (time since the
+* start of the capture, old and new inputs) to a single-producer,
+* single-consumer ring. The consumer drains the ring to the UART in batches,
+* only as much as the TX ring can take at once, so sampling never waits on
+* the serial line; events that find the ring full are counted as dropped.
+*
+* Producer and consumer each write only their own index, so the ring needs
+* no lock; EDGE_BARRIER() keeps the compiler from moving the event store past
+* the index store (one core, so no hardware barrier is needed).
+*
+* Each drained edge is printed with, for every input that changed, the time
+* since that input's previous edge, i.e. the bounce or pulse width.
+******************************************************************************/
+#ifndef EDGE_CAP_H
+#define EDGE_CAP_H
+
+#include "fixture.h"
+
+#define EDGE_RING_SIZE		4096	/* Power of two */
+#define EDGE_INPUTS			7		/* Input_1..Input_7, data4 bits 6:0 */
+
+#define EDGE_BARRIER()		__asm__ __volatile__("" ::: "memory")
+
+typedef struct {
+	u32 AtUs;				/* From the start of the capture */
+	u8 Old;
+	u8 New;
+} EdgeEvent;
+
+typedef struct {
+	EdgeEvent Event[EDGE_RING_SIZE];
+	volatile u32 Head;		/* Written by the producer only */
+	volatile u32 Tail;		/* Written by the consumer only */
+	volatile u32 Dropped;
+} EdgeRing;
+
+typedef struct {
+	u32 Samples;
+	u32 Edges;
+	u32 Timeouts;
+	u32 ElapsedUs;
+	u32 MaxGapUs;			/* Longest time between two samples */
+	u32 MinPulseUs[EDGE_INPUTS];	/* Shortest time between two edges of an input */
+} EdgeCapSummary;
+
+int EdgeRing_Push(EdgeRing *R, const EdgeEvent *E);
+int EdgeRing_Pop(EdgeRing *R, EdgeEvent *E);
+
+int EdgeCap_Run(const FixtureConfig *Config, u8 SHnum, u32 DurationMs);
+void EdgeCap_PrintSummary(void);
+
+#endif
@@ -0,0 +1,1190 @@
+/******************************************************************************
+* fixture.c: one fixture handshake cycle and its keyboard controls
+*
+* This is the body of the while (pass) loop from the base application, moved
+* behind the bram_cmd/uart_cli layer so it builds for the board and for the
+* Linux simulator alike.
+******************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include "fixture.h"
+#include "bram_cmd.h"
+#include "cmd_queue.h"
+#include "status_stream.h"
+#include "record.h"
+#include "sweep.h"
+#include "relay_seq.h"
+#include "edge_cap.h"
+#include "soak.h"
+#include "station.h"
+#include "render.h"
+#include "trace.h"
+#include "stats.h"
+#include "fmt.h"
+#include "uart_cli.h"
+#include "sched.h"
+#include "prof.h"
+#include "timebase.h"
+
+/* Passes through the relay sequence table run by the 'e' key */
+#define RELAY_SEQ_KEY_REPEAT	1000
+
+/* Input edge capture time of the 'k' key */
+#define EDGE_KEY_CAPTURE_MS		1000
+
+/* Random frames checked against the reference model by the 'o' key */
+#define SOAK_KEY_CYCLES		1000000
+
+/* Records with an error printed by the 'r' key */
+#define TRACE_KEY_DUMP		32
+
+/* Every relay combination, then the commanded relays again */
+#define RELAY_TEST_FRAMES	(RELAY_ALL + 2)
+
+static u32 TestFrames[RELAY_TEST_FRAMES][CMD_WORDS];
+static u32 TestResponses[RELAY_TEST_FRAMES][RSP_WORDS];
+
+static SweepTable Sweep;
+static SoakResult Soak;
+
+void Fixture_Init(Fixture *F)
+{
+	int i;
+
+	F->Reset = RESET_RELEASE;
+	F->Config.Pos = 0;
+	F->Config.BoardId = Board_Id;
+	F->CpldRev1 = 0x00000000;
+	F->CpldRev2 = 0x00000000;
+	F->OutputMode = FIXTURE_OUTPUT_DEFAULT;
+	F->LineMode = 0;
+	F->Seq = 0;
+	F->Status = XST_SUCCESS;
+	F->TurnaroundUs = 0;
+	F->TurnaroundMaxUs = 0;
+	F->Timeouts = 0;
+	F->Issued = 0;
+	F->Completed = 0;
+	for (i = 0; i < RSP_WORDS; i++) {
+		F->Data[i] = 0;
+	}
+	Fixture_Start(F);
+	BramCmd_WriteReset(F->Reset);
+	Fixture_SetPingPong(F, FIXTURE_PINGPONG);
+}
+
+/*
+ * Return the command state to its power-on values before a new run.
+ */
+void Fixture_Start(Fixture *F)
+{
+	F->SHnum = 0;
+
+	// INITIALIZE COMMAND //
+	F->Config.CommandType = DataUpdate;
+	F->Config.ModId = Mod_Id;
+	F->Config.Threshold = Threshold_166V;
+	F->Config.DryWet = Wet;
+	F->Config.Synchronization = NoSynch;
+
+	// INITIALIZE RELAYS //
+	F->Config.Relays = 0x00000000;
+
+	BramCmd_BuildFrame(&F->Config, F->SHnum, F->Command);
+	BramCmd_InvalidateCache(&F->Cache);
+	Render_Invalidate();
+	F->Completed = F->Issued;
+}
+
+static void NextSHnum(Fixture *F)
+{
+	if (F->SHnum == SHNUM_WRAP) {
+		F->SHnum = 0;
+	}
+	else {
+		if (F->Config.Synchronization == NoSynch) F->SHnum += 1;
+		else F->SHnum = 0;
+	}
+}
+
+static void StageCommand(Fixture *F, u32 *Command)
+{
+	const u32 *Frame;
+	int i;
+
+	Frame = BramCmd_CachedFrame(&F->Cache, &F->Config, F->SHnum);
+	for (i = 0; i < CMD_WORDS; i++) {
+		Command[i] = Frame[i];
+	}
+}
+
+/*
+ * Book-keeping once the response to F->Command has arrived in Slot (or, if
+ * not NULL, in Response), or the wait for it failed with F->Status.
+ */
+static void FinishFrame(Fixture *F, u32 Slot, const u32 *Response, u64 Written)
+{
+	u64 Now = Time_Now();
+	int i;
+
+	F->Finished = Now;
+	F->TurnaroundUs = (u32)Time_TicksToUs(Now - Written);
+	if (F->Status != XST_SUCCESS) {
+		F->Timeouts++;
+		for (i = 0; i < RSP_WORDS; i++) {
+			F->Data[i] = 0;
+		}
+	}
+	else {
+		if (F->TurnaroundUs > F->TurnaroundMaxUs) {
+			F->TurnaroundMaxUs = F->TurnaroundUs;
+		}
+
+		if (Response != NULL) {
+			for (i = 0; i < RSP_WORDS; i++) {
+				F->Data[i] = Response[i];
+			}
+		}
+		else {
+			PROF_BEGIN(PROF_READ);
+			BramCmd_ReadSlot(Slot, F->Data);
+			PROF_END(PROF_READ);
+		}
+		if (((F->Command[1] >> POS_CommandType) & 0x3) == CPLDRev) {
+			F->CpldRev1 = F->Data[2];
+			F->CpldRev2 = F->Data[3];
+		}
+	}
+	F->Seq++;
+	Trace_Record(F, Now);
+	Stats_Update(F);
+}
+
+/*
+ * Ping-pong mode: stage frame N+1 in the free BRAM0 slot, then collect the
+ * response to frame N while the CPLD works on N+1.
+ */
+static int CyclePingPong(Fixture *F)
+{
+	StagedFrame *Stage;
+	u32 Slot;
+	int i;
+
+	Slot = F->Issued % PP_SLOTS;
+	Stage = &F->Staged[Slot];
+	F->Status = BramCmd_WaitHandshake(HS_WRITE_EN,
+			Time_Now() + Time_UsToTicks(FIXTURE_READEN_TIMEOUT_US));
+	if (F->Status == XST_SUCCESS) {
+		PROF_BEGIN(PROF_WRITE);
+		StageCommand(F, Stage->Command);
+		Stage->Count = F->NextCount++;
+		BramCmd_WriteSlot(Slot, Stage->Command);
+		PROF_END(PROF_WRITE);
+		Stage->Written = Time_Now();
+		F->Issued++;
+		NextSHnum(F);
+		if (F->Issued - F->Completed < PP_SLOTS) {
+			return XST_NO_DATA;		/* Pipeline still filling */
+		}
+	}
+	else if (F->Issued == F->Completed) {
+		StageCommand(F, F->Command);
+		FinishFrame(F, 0, NULL, Time_Now());
+		return F->Status;
+	}
+
+	Slot = F->Completed % PP_SLOTS;
+	Stage = &F->Staged[Slot];
+	for (i = 0; i < CMD_WORDS; i++) {
+		F->Command[i] = Stage->Command[i];
+	}
+	PROF_BEGIN(PROF_READEN);
+	F->Status = BramCmd_WaitResponse(Slot, Stage->Count,
+			Stage->Written + Time_UsToTicks(FIXTURE_READEN_TIMEOUT_US));
+	PROF_END(PROF_READEN);
+	F->Completed++;
+	FinishFrame(F, Slot, NULL, Stage->Written);
+
+	if (F->Status != XST_SUCCESS) {
+		Fixture_SetPingPong(F, 1);	/* Drop what is in flight and resync */
+	}
+	return F->Status;
+}
+
+/****************************************************************************/
+/**
+*
+* Write one COMMAND frame to BRAM0, wait for ReadEn and read the response
+* from BRAM1 into F->Data. The write-to-ReadEn time is kept in
+* F->TurnaroundUs. If ReadEn does not rise within FIXTURE_READEN_TIMEOUT_US
+* the frame is abandoned, F->Data is cleared and F->Timeouts counts it.
+*
+* In ping-pong mode the response collected belongs to the frame staged on
+* the previous call, and F->Command is set to that frame.
+*
+* @param	F is the fixture state. SHnum is advanced on return.
+*
+* @return	XST_SUCCESS, XST_FAILURE on handshake timeout, or XST_NO_DATA
+*		while the ping-pong pipeline is filling.
+*
+*****************************************************************************/
+int Fixture_Cycle(Fixture *F)
+{
+	u64 Written;
+
+	if (F->PingPong) {
+		return CyclePingPong(F);
+	}
+
+	F->Status = XST_SUCCESS;
+	if (FIXTURE_WAIT_WRITE_EN) {
+		F->Status = BramCmd_WaitHandshake(HS_WRITE_EN,
+				Time_Now() + Time_UsToTicks(FIXTURE_READEN_TIMEOUT_US));
+	}
+
+	PROF_BEGIN(PROF_WRITE);
+	StageCommand(F, F->Command);
+	Written = Time_Now();
+	if (F->Status == XST_SUCCESS) {
+		BramCmd_WriteFrame(F->Command);
+		PROF_END(PROF_WRITE);
+		Written = Time_Now();
+		PROF_BEGIN(PROF_READEN);
+		F->Status = BramCmd_WaitHandshake(HS_READ_EN,
+				Written + Time_UsToTicks(FIXTURE_READEN_TIMEOUT_US));
+		PROF_END(PROF_READEN);
+	}
+	FinishFrame(F, 0, NULL, Written);
+	NextSHnum(F);
+
+	return F->Status;
+}
+
+/*
+ * Station cycles (see station.h) move the frames themselves: Fixture_Stage()
+ * puts the frame for the current SHnum in F->Command, Fixture_Complete()
+ * takes its response, all zero if it never came, and advances SHnum.
+ */
+void Fixture_Stage(Fixture *F)
+{
+	StageCommand(F, F->Command);
+}
+
+void Fixture_Complete(Fixture *F, const u32 *Response, u64 Written)
+{
+	/* Every real response echoes the HEADER in data1 */
+	F->Status = Response[0] != 0 ? XST_SUCCESS : XST_FAILURE;
+	FinishFrame(F, 0, Response, Written);
+	NextSHnum(F);
+}
+
+/*
+ * Take a recorded frame (see record.h, replay_host.c) as if Command had just
+ * been answered with Response, TurnaroundUs before the current Time_Now().
+ * The configuration and SHnum are decoded from Command.
+ */
+void Fixture_Replay(Fixture *F, const u32 *Command, const u32 *Response, int Status,
+		u32 TurnaroundUs)
+{
+	int i;
+
+	for (i = 0; i < CMD_WORDS; i++) {
+		F->Command[i] = Command[i];
+	}
+	BramCmd_ParseFrame(Command, &F->Config, &F->SHnum);
+	F->Status = Status;
+	FinishFrame(F, 0, Response, Time_Now() - Time_UsToTicks(TurnaroundUs));
+}
+
+/****************************************************************************/
+/**
+*
+* Switch BRAM0 between single-frame and ping-pong staging. Frames still in
+* flight are abandoned and the response count is resynchronized, so this is
+* also the recovery path after a ping-pong timeout.
+*
+* @param	F is the fixture state.
+* @param	Enable is 1 for ping-pong, 0 for one frame per handshake.
+*
+* @return	None.
+*
+*****************************************************************************/
+void Fixture_SetPingPong(Fixture *F, int Enable)
+{
+	u16 Count0;
+	u16 Count1;
+
+	F->PingPong = (u8)Enable;
+	F->Completed = F->Issued;
+	BramCmd_SetMode(Enable ? BRAM_MODE_PINGPONG : BRAM_MODE_SINGLE);
+
+	Count0 = BramCmd_ResponseCount(0);
+	Count1 = BramCmd_ResponseCount(1);
+	F->NextCount = (u16)(((s16)(Count1 - Count0) > 0 ? Count1 : Count0) + 1);
+}
+
+/****************************************************************************/
+/**
+*
+* Step the relays through all RELAY_ALL + 1 combinations with ChangeRequest
+* frames and check that each response reads back the relays commanded. The
+* sequence is sent once through the command ring and once with one handshake
+* per frame; the time, relay mismatches and lost frames of both are printed. The relays are left as commanded
+* in F->Config, and BRAM0 is returned to the mode it was in.
+*
+* @param	F is the fixture state.
+*
+* @return	None.
+*
+*****************************************************************************/
+void Fixture_RelayTest(Fixture *F)
+{
+	FixtureConfig Test = F->Config;
+	CmdQueue Q;
+	u32 Mismatches[2] = { 0, 0 };
+	u32 Lost[2] = { 0, 0 };
+	u64 Start;
+	u64 Queued;
+	u64 Single;
+	u32 n;
+
+	Test.CommandType = ChangeRequest;
+	for (n = 0; n < RELAY_TEST_FRAMES; n++) {
+		Test.Relays = n <= RELAY_ALL ? n : F->Config.Relays;
+		BramCmd_BuildFrame(&Test, F->SHnum, TestFrames[n]);
+	}
+
+	CmdQueue_Reset(&Q);
+	Start = Time_Now();
+	CmdQueue_Run(&Q, (const u32 (*)[CMD_WORDS])TestFrames, RELAY_TEST_FRAMES, TestResponses);
+	Queued = Time_Now() - Start;
+	Lost[0] = Q.Lost;
+	for (n = 0; n <= RELAY_ALL; n++) {
+		if ((TestResponses[n][2] & RSP_RELAY_MASK) != n) {
+			Mismatches[0]++;
+		}
+	}
+
+	BramCmd_SetMode(BRAM_MODE_SINGLE);
+	Start = Time_Now();
+	for (n = 0; n < RELAY_TEST_FRAMES; n++) {
+		BramCmd_WriteFrame(TestFrames[n]);
+		if (BramCmd_WaitHandshake(HS_READ_EN,
+				Time_Now() + Time_UsToTicks(FIXTURE_READEN_TIMEOUT_US)) != XST_SUCCESS) {
+			Lost[1]++;
+			continue;
+		}
+		BramCmd_ReadFrame(TestResponses[n]);
+		if (n <= RELAY_ALL && (TestResponses[n][2] & RSP_RELAY_MASK) != n) {
+			Mismatches[1]++;
+		}
+	}
+	Single = Time_Now() - Start;
+	Fixture_SetPingPong(F, F->PingPong);
+
+	xil_printf("RELAY TEST: %d frames\r\n", RELAY_TEST_FRAMES);
+	xil_printf("  queued:     %d us, %d relay mismatches, %d lost\r\n",
+			(u32)Time_TicksToUs(Queued), Mismatches[0], Lost[0]);
+	xil_printf("  one by one: %d us, %d relay mismatches, %d lost\r\n",
+			(u32)Time_TicksToUs(Single), Mismatches[1], Lost[1]);
+}
+
+/*
+ * Run the selected relay sequence table Repeat times (see relay_seq.h) and
+ * print its summary. BRAM0 is returned to the mode it was in.
+ */
+void Fixture_RelaySequence(Fixture *F, u32 Repeat)
+{
+	if (RelaySeq_Run(&F->Config, F->SHnum, Repeat) != XST_SUCCESS) {
+		xil_printf("ERR relay sequence empty or over %d steps\r\n", FIXTURE_RELAY_SEQ_RESULTS);
+		return;
+	}
+	Fixture_SetPingPong(F, F->PingPong);
+	RelaySeq_PrintSummary();
+	Render_Invalidate();
+}
+
+/*
+ * Capture contact input edges for DurationMs (see edge_cap.h) and print the
+ * summary. BRAM0 is returned to the mode it was in.
+ */
+void Fixture_Capture(Fixture *F, u32 DurationMs)
+{
+	EdgeCap_Run(&F->Config, F->SHnum, DurationMs);
+	Fixture_SetPingPong(F, F->PingPong);
+	EdgeCap_PrintSummary();
+	Render_Invalidate();
+}
+
+/*
+ * Check Cycles random frames against the reference model (see soak.h) and
+ * print the summary. Seed 0 picks one from the clock; the summary shows it.
+ * Reset, BRAM0 mode and the commanded settings are restored afterwards.
+ */
+void Fixture_Soak(Fixture *F, u32 Cycles, u32 Seed)
+{
+	if (Seed == 0) {
+		Seed = (u32)Time_Now() | 1;
+	}
+	Soak_Run(&Soak, &F->Config, Cycles, Seed);
+	BramCmd_WriteReset(F->Reset);
+	Fixture_SetPingPong(F, F->PingPong);
+	Soak_PrintSummary(&Soak);
+	Render_Invalidate();
+}
+
+/*
+ * Run a sample-and-hold sweep of the commanded state and report it in the
+ * current output mode: one binary blob, or a text summary.
+ */
+void Fixture_Sweep(Fixture *F)
+{
+	Sweep_Run(&Sweep, &F->Cache, &F->Config, FIXTURE_SWEEP_RING);
+	Fixture_SetPingPong(F, F->PingPong);
+
+	if (F->OutputMode == OUTPUT_BINARY) {
+		Sweep_Send(&Sweep);
+	}
+	else {
+		Sweep_PrintSummary(&Sweep);
+		Render_Invalidate();
+	}
+}
+
+/*
+ * Time the per-word and burst BRAM accesses over Frames handshaked DataUpdate
+ * frames of the commanded state (see BramCmd_Benchmark()). BRAM0 is returned
+ * to the mode it was in.
+ */
+void Fixture_BramBenchmark(Fixture *F, u32 Frames)
+{
+	FixtureConfig Bench = F->Config;
+	u32 Frame[CMD_WORDS];
+
+	Bench.CommandType = DataUpdate;
+	BramCmd_BuildFrame(&Bench, F->SHnum, Frame);
+	BramCmd_Benchmark(Frame, Frames);
+	Fixture_SetPingPong(F, F->PingPong);
+	Render_Invalidate();
+}
+
+/////////////////////////////////// TEXT VIEW ////////////////////////////////////////////////////
+static const FmtText CommandLabel[CMD_WORDS] = {
+	FMT_TEXT("Command1 = 0x"), FMT_TEXT("Command2 = 0x"), FMT_TEXT("Command3 = 0x"),
+	FMT_TEXT("Command4 = 0x"), FMT_TEXT("Command5 = 0x"),
+};
+
+static const FmtText DataLabel[RSP_WORDS] = {
+	FMT_TEXT("Data Read Address 0 (data1): 0x"), FMT_TEXT("Data Read Address 4 (data2): 0x"),
+	FMT_TEXT("Data Read Address 8 (data3): 0x"), FMT_TEXT("Data Read Address 12 (data4): 0x"),
+	FMT_TEXT("Data Read Address 16 (data5): 0x"), FMT_TEXT("Data Read Address 20 (data6): 0x"),
+	FMT_TEXT("Data Read Address 24 (data7): 0x"),
+};
+
+/* Indexed by CommandType */
+static const FmtText CommandText[4] = {
+	FMT_TEXT(""),
+	FMT_TEXT("COMMAND = CHANGE REQUEST\n\r"),
+	FMT_TEXT("COMMAND = DATA UPDATE ONLY, can't operate relays\n\r"),
+	FMT_TEXT(""),
+};
+
+static void FormatFrame(FmtBuf *B, const Fixture *F)
+{
+	int i;
+
+	Fmt_Lit(B, "Writing COMMAND\r\n");
+	for (i = 0; i < CMD_WORDS; i++) {
+		Fmt_Text(B, &CommandLabel[i]);
+		Fmt_Hex4(B, F->Command[i]);
+		Fmt_Lit(B, "\r\n");
+	}
+
+	Fmt_Lit(B, "Reading DATA \r\n");
+	for (i = 0; i < RSP_WORDS; i++) {
+		Fmt_Text(B, &DataLabel[i]);
+		Fmt_Hex4(B, F->Data[i]);
+		Fmt_Lit(B, "\n\r");
+	}
+	Fmt_Lit(B, "TURNAROUND = ");
+	Fmt_Dec(B, F->TurnaroundUs);
+	Fmt_Lit(B, " us (max ");
+	Fmt_Dec(B, F->TurnaroundMaxUs);
+	Fmt_Lit(B, " us), TIMEOUTS = ");
+	Fmt_Dec(B, F->Timeouts);
+	Fmt_Lit(B, "\n\r");
+	Fmt_Lit(B, "\n\r");
+}
+
+static void FormatStatus(FmtBuf *B, const Fixture *F)
+{
+	const RenderLine *Line;
+	u32 Row = Render_Status[0].Row;
+	u32 i;
+
+	if (F->Reset) {
+		Fmt_Lit(B, "FIXTURE IN OPERATION\n\r");
+	}
+	else Fmt_Lit(B, "FIXTURE IN RESET\n\r");
+	Fmt_Lit(B, "\n\r");
+
+	Fmt_Text(B, &CommandText[F->Config.CommandType & 0x3]);
+	Fmt_Lit(B, "\n\r");
+
+	Fmt_Lit(B, "CPLD_REV MM-DD = 0x");
+	Fmt_Hex4(B, F->CpldRev1);
+	Fmt_Lit(B, "\n\rCPLD_REV YY-RR = 0x");
+	Fmt_Hex4(B, F->CpldRev2);
+	Fmt_Lit(B, "\n\r");
+
+	for (i = 0; i < RENDER_STATUS_LINES; i++) {
+		Line = &Render_Status[i];
+		if (Line->Row > Row + 1) {
+			Fmt_Lit(B, "\n\r");
+		}
+		Row = Line->Row;
+		Fmt_Text(B, &Line->Text[Render_Value(Line, F->Data)]);
+		Fmt_Lit(B, "\n\r");
+	}
+}
+
+/*
+ * Send the result of the last Fixture_Cycle() in the selected output mode.
+ */
+void Fixture_Report(const Fixture *F)
+{
+	if (F->OutputMode == OUTPUT_BINARY) {
+		Stream_SendRecord(F);
+		return;
+	}
+	if (F->OutputMode == OUTPUT_DELTA) {
+		Render_Delta(F);
+		return;
+	}
+	if (F->OutputMode == OUTPUT_TRACE) {
+		Trace_Report(F);
+		return;
+	}
+	if (F->OutputMode == OUTPUT_STATS) {
+		Stats_Report(F);
+		return;
+	}
+	if (F->OutputMode == OUTPUT_RECORD) {
+		Record_Send(F);
+		return;
+	}
+
+	FormatFrame(&Fmt_View, F);
+	if (F->Status != XST_SUCCESS) {
+		Fmt_Lit(&Fmt_View, "HANDSHAKE TIMEOUT, no ReadEn after ");
+		Fmt_Dec(&Fmt_View, FIXTURE_READEN_TIMEOUT_US);
+		Fmt_Lit(&Fmt_View, " us (");
+		Fmt_Dec(&Fmt_View, F->Timeouts);
+		Fmt_Lit(&Fmt_View, " timeouts)\n\r");
+	}
+	FormatStatus(&Fmt_View, F);
+
+	Fmt_Lit(&Fmt_View, "\033[2J");   // Clear screen
+	Fmt_Lit(&Fmt_View, "\033[H");    // Move cursor to home position
+	Fmt_Flush(&Fmt_View);
+}
+
+/****************************************************************************/
+/**
+*
+* Apply one keyboard command typed during a run.
+*
+* @param	F is the fixture state.
+* @param	Key is the received character.
+*
+* @return	0 if the run should stop ('0'), 1 otherwise.
+*
+*****************************************************************************/
+int Fixture_HandleKey(Fixture *F, u8 Key)
+{
+	if (F->OutputMode == OUTPUT_TEXT) {
+		xil_printf("recv_char: %c \r\n", Key);
+	}
+	switch (Key) {
+	case '0':
+		if (F->OutputMode == OUTPUT_BINARY || F->OutputMode == OUTPUT_RECORD) xil_printf("\r\n");
+		xil_printf("Please type 1 to continue: \r\n");
+		F->CpldRev1 = 0x00000000; // reset to all zero
+		F->CpldRev2 = 0x00000000; // reset to all zero
+		return 0;
+
+	case '2':
+		F->Config.CommandType = ChangeRequest;
+		if (F->Config.Threshold == Threshold_17V) {
+			F->Config.Threshold = Threshold_33V;
+		}
+		else if (F->Config.Threshold == Threshold_33V) {
+			F->Config.Threshold = Threshold_84V;
+		}
+		else if (F->Config.Threshold == Threshold_84V) {
+			F->Config.Threshold = Threshold_166V;
+		}
+		else if (F->Config.Threshold == Threshold_166V) {
+			F->Config.Threshold = Threshold_17V;
+		}
+		break;
+
+	case '3':
+		F->Config.CommandType = ChangeRequest;
+		if (F->Config.DryWet == Wet) F->Config.DryWet = Dry;
+		else F->Config.DryWet = Wet;
+		break;
+
+	case '4':
+		F->Config.CommandType = ChangeRequest;
+		if (F->Config.Synchronization == NoSynch) F->Config.Synchronization = Synch;
+		else F->Config.Synchronization = NoSynch;
+		break;
+
+	case '5':
+		F->Config.CommandType = DataUpdate;
+		break;
+
+	case '6':
+		F->Config.CommandType = ChangeRequest;
+		break;
+
+	case '7':
+		if (F->Reset == RESET_RELEASE) F->Reset = RESET_ASSERT;
+		else F->Reset = RESET_RELEASE;
+		BramCmd_WriteReset(F->Reset);
+		break;
+
+	case '8':
+		BramCmd_WriteReset(RESET_ASSERT);		//assert reset
+		Time_DelayUs(FIXTURE_RESET_PULSE_US);	//delay
+		BramCmd_WriteReset(RESET_RELEASE);		//de-assert reset
+		F->Config.CommandType = CPLDRev;
+		BramCmd_WriteCommand(0, BramCmd_CachedFrame(&F->Cache, &F->Config, 0)[1]);
+		break;
+
+	case 'a':
+		F->Config.CommandType = ChangeRequest;
+		F->Config.Relays ^= RELAY_AA;
+		break;
+
+	case 's':
+		F->Config.CommandType = ChangeRequest;
+		F->Config.Relays ^= RELAY_AB;
+		break;
+
+	case 'd':
+		F->Config.CommandType = ChangeRequest;
+		F->Config.Relays ^= RELAY_CA;
+		break;
+
+	case 'f':
+		F->Config.CommandType = ChangeRequest;
+		F->Config.Relays ^= RELAY_CB;
+		break;
+
+	case 'g':
+		F->Config.CommandType = ChangeRequest;
+		F->Config.Relays ^= RELAY_CC;
+		break;
+
+	case 'z':
+		F->Config.Relays = 0x00000000;
+		break;
+
+	case 'x':
+		F->Config.Relays = RELAY_ALL;
+		break;
+
+	case 't':
+		if (F->OutputMode == OUTPUT_BINARY) F->OutputMode = OUTPUT_TEXT;
+		else if (F->OutputMode == OUTPUT_TEXT) F->OutputMode = OUTPUT_DELTA;
+		else if (F->OutputMode == OUTPUT_DELTA) F->OutputMode = OUTPUT_TRACE;
+		else if (F->OutputMode == OUTPUT_TRACE) F->OutputMode = OUTPUT_STATS;
+		else F->OutputMode = OUTPUT_BINARY;
+		Render_Invalidate();
+		break;
+
+	case '+':
+		Sched_SetPeriod(Sched_Period() / 2);
+		break;
+
+	case '-':
+		if (Sched_SetPeriod(Sched_Period() ? Sched_Period() * 2 : SCHED_MIN_PERIOD_US) != XST_SUCCESS) {
+			xil_printf("Period limit is %d us\r\n", SCHED_MAX_PERIOD_US);
+		}
+		break;
+
+	case 'w':
+		if (Station_SetPingPong(!F->PingPong) != XST_SUCCESS) {
+			xil_printf("Ping-pong needs the station ring\r\n");
+		}
+		break;
+
+	case 'p':
+		Fixture_BramBenchmark(F, 10000);
+		break;
+
+	case 'n':
+		Station_Select((Station_SelectedIndex() + 1) % FIXTURE_COUNT);
+		break;
+
+	case 'c':
+		F->LineMode = 1;
+		xil_printf("Command line mode, 'keys' to return\r\n");
+		break;
+
+	case 'q':
+		Fixture_RelayTest(F);
+		break;
+
+	case 'm':
+		Fixture_Sweep(F);
+		break;
+
+	case 'e':
+		Fixture_RelaySequence(F, RELAY_SEQ_KEY_REPEAT);
+		break;
+
+	case 'k':
+		Fixture_Capture(F, EDGE_KEY_CAPTURE_MS);
+		break;
+
+	case 'o':
+		Fixture_Soak(F, SOAK_KEY_CYCLES, 0);
+		break;
+
+	case 'r':
+		Trace_Dump(TRACE_ANY_ERROR, TRACE_KEY_DUMP);
+		break;
+
+	case 'v':
+		Stats_Print(F);
+		break;
+
+	case 'b':
+		if (UartCli_NextBaudRate() != XST_SUCCESS) {
+			xil_printf("Failed to set baud rate\r\n");
+		}
+		break;
+
+#if FIXTURE_PROFILE
+	case 'i':
+		Prof_Dump();
+		Prof_Reset();
+		break;
+#endif
+	}
+
+	return 1;
+}
+
+/////////////////////////////////// COMMAND LINES ////////////////////////////////////////////////
+static int LinePass;
+
+/* Parse a number, decimal or 0x hex, that must fill the whole word */
+static int ParseU32(const char *Word, u32 *Value)
+{
+	char *End;
+
+	*Value = (u32)strtoul(Word, &End, 0);
+	return *End == '\0' && End != Word;
+}
+
+/* Index of Word in the NULL-terminated list Names, or -1 */
+static int Lookup(const char *Word, const char *const *Names)
+{
+	int i;
+
+	for (i = 0; Names[i] != NULL; i++) {
+		if (strcmp(Word, Names[i]) == 0) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+static int BadArg(const char *Word)
+{
+	xil_printf("ERR bad argument %s\r\n", Word);
+	return XST_FAILURE;
+}
+
+static const char *const OnOff[] = { "off", "on", NULL };
+
+static int CmdThr(void *Ref, int Argc, char *Argv[])
+{
+	static const char *const Volts[] = { "166", "84", "33", "17", NULL };
+	Fixture *F = Ref;
+	int i = Lookup(Argv[1], Volts);
+
+	(void)Argc;
+	if (i < 0) return BadArg(Argv[1]);
+	F->Config.CommandType = ChangeRequest;
+	F->Config.Threshold = (u32)i;		/* Threshold_166V..Threshold_17V */
+	return XST_SUCCESS;
+}
+
+static int CmdDw(void *Ref, int Argc, char *Argv[])
+{
+	static const char *const Modes[] = { "wet", "dry", NULL };
+	Fixture *F = Ref;
+	int i = Lookup(Argv[1], Modes);
+
+	(void)Argc;
+	if (i < 0) return BadArg(Argv[1]);
+	F->Config.CommandType = ChangeRequest;
+	F->Config.DryWet = (u32)i;
+	return XST_SUCCESS;
+}
+
+static int CmdSync(void *Ref, int Argc, char *Argv[])
+{
+	Fixture *F = Ref;
+	int i = Lookup(Argv[1], OnOff);
+
+	(void)Argc;
+	if (i < 0) return BadArg(Argv[1]);
+	F->Config.CommandType = ChangeRequest;
+	F->Config.Synchronization = (u32)i;
+	return XST_SUCCESS;
+}
+
+static int CmdRelays(void *Ref, int Argc, char *Argv[])
+{
+	Fixture *F = Ref;
+	u32 Mask;
+
+	(void)Argc;
+	if (!ParseU32(Argv[1], &Mask) || (Mask & ~RELAY_ALL)) return BadArg(Argv[1]);
+	F->Config.CommandType = ChangeRequest;
+	F->Config.Relays = Mask;
+	return XST_SUCCESS;
+}
+
+static int CmdRelay(void *Ref, int Argc, char *Argv[])
+{
+	static const char *const Names[] = { "aa", "ab", "ca", "cb", "cc", NULL };
+	Fixture *F = Ref;
+	int r = Lookup(Argv[1], Names);
+	int On = Lookup(Argv[2], OnOff);
+
+	(void)Argc;
+	if (r < 0) return BadArg(Argv[1]);
+	if (On < 0) return BadArg(Argv[2]);
+	F->Config.CommandType = ChangeRequest;
+	if (On) F->Config.Relays |= 1u << r;		/* RELAY_AA..RELAY_CC */
+	else F->Config.Relays &= ~(1u << r);
+	return XST_SUCCESS;
+}
+
+static int CmdType(void *Ref, int Argc, char *Argv[])
+{
+	static const char *const Types[] = { "cpldrev", "change", "update", NULL };
+	Fixture *F = Ref;
+	int i = Lookup(Argv[1], Types);
+
+	(void)Argc;
+	if (i < 0) return BadArg(Argv[1]);
+	F->Config.CommandType = (u32)i;		/* CPLDRev, ChangeRequest, DataUpdate */
+	return XST_SUCCESS;
+}
+
+static int CmdSh(void *Ref, int Argc, char *Argv[])
+{
+	Fixture *F = Ref;
+	u32 Sh;
+
+	(void)Argc;
+	if (!ParseU32(Argv[1], &Sh) || Sh > SHNUM_WRAP) return BadArg(Argv[1]);
+	F->SHnum = (u8)Sh;
+	return XST_SUCCESS;
+}
+
+static int CmdReset(void *Ref, int Argc, char *Argv[])
+{
+	static const char *const Actions[] = { "assert", "release", "pulse", NULL };
+	Fixture *F = Ref;
+	int i = Lookup(Argv[1], Actions);
+
+	(void)Argc;
+	if (i < 0) return BadArg(Argv[1]);
+	if (i == 2) {
+		Fixture_HandleKey(F, '8');
+	}
+	else {
+		F->Reset = i ? RESET_RELEASE : RESET_ASSERT;
+		BramCmd_WriteReset(F->Reset);
+	}
+	return XST_SUCCESS;
+}
+
+/*
+ * Run N station cycles back to back, each reported as in the main loop,
+ * without waiting for the cycle period.
+ */
+static int CmdRun(void *Ref, int Argc, char *Argv[])
+{
+	int Status = XST_SUCCESS;
+	u32 n;
+
+	(void)Ref;
+	(void)Argc;
+	if (!ParseU32(Argv[1], &n) || n > FIXTURE_RUN_MAX) return BadArg(Argv[1]);
+	while (n-- && !UartCli_TryRecvCancel()) {
+		PROF_BEGIN(PROF_CYCLE);
+		Status = Station_Cycle();
+		PROF_END(PROF_CYCLE);
+		if (Status != XST_NO_DATA) {
+			PROF_BEGIN(PROF_REPORT);
+			Station_Report();
+			PROF_END(PROF_REPORT);
+		}
+	}
+	return Status == XST_FAILURE ? XST_FAILURE : XST_SUCCESS;
+}
+
+static int CmdOut(void *Ref, int Argc, char *Argv[])
+{
+	static const char *const Modes[] = { "text", "binary", "delta", "trace", "stats", "record", NULL };
+	Fixture *F = Ref;
+	int i = Lookup(Argv[1], Modes);
+
+	(void)Argc;
+	if (i < 0) return BadArg(Argv[1]);
+	F->OutputMode = (u8)i;		/* OUTPUT_TEXT .. OUTPUT_RECORD */
+	if (i == OUTPUT_RECORD) {
+		Record_Start();
+	}
+	Render_Invalidate();
+	return XST_SUCCESS;
+}
+
+static int CmdPeriod(void *Ref, int Argc, char *Argv[])
+{
+	u32 Us;
+
+	(void)Ref;
+	(void)Argc;
+	if (!ParseU32(Argv[1], &Us) || Us > SCHED_MAX_PERIOD_US) return BadArg(Argv[1]);
+	return Sched_SetPeriod(Us);
+}
+
+static int CmdPingPong(void *Ref, int Argc, char *Argv[])
+{
+	int i = Lookup(Argv[1], OnOff);
+
+	(void)Ref;
+	(void)Argc;
+	if (i < 0) return BadArg(Argv[1]);
+	if (Station_SetPingPong(i) != XST_SUCCESS) {
+		xil_printf("ERR ping-pong needs the station ring\r\n");
+		return XST_FAILURE;
+	}
+	return XST_SUCCESS;
+}
+
+static int CmdBaud(void *Ref, int Argc, char *Argv[])
+{
+	u32 Rate;
+
+	(void)Ref;
+	(void)Argc;
+	if (!ParseU32(Argv[1], &Rate)) return BadArg(Argv[1]);
+	return UartCli_SetBaudRate(Rate);
+}
+
+/* Commands that map straight onto a key of Fixture_HandleKey() */
+static int CmdKey(void *Ref, int Argc, char *Argv[])
+{
+	static const char *const Names[] = { "sweep", "relaytest", "bench", "stop", NULL };
+	static const u8 Keys[] = { 'm', 'q', 'p', '0' };
+
+	(void)Argc;
+	LinePass = Fixture_HandleKey(Ref, Keys[Lookup(Argv[0], Names)]);
+	return XST_SUCCESS;
+}
+
+static int CmdFix(void *Ref, int Argc, char *Argv[])
+{
+	u32 Index;
+
+	(void)Ref;
+	(void)Argc;
+	if (!ParseU32(Argv[1], &Index) || Station_Select(Index) != XST_SUCCESS) {
+		return BadArg(Argv[1]);
+	}
+	return XST_SUCCESS;
+}
+
+static int CmdTrace(void *Ref, int Argc, char *Argv[])
+{
+	static const char *const Actions[] = { "off", "on", "clear", NULL };
+	int i;
+
+	(void)Ref;
+	if (Argc > 1) {
+		i = Lookup(Argv[1], Actions);
+		if (i < 0) return BadArg(Argv[1]);
+		if (i == 2) Trace_Clear();
+		else Trace_Enable(i);
+	}
+	Trace_PrintStatus();
+	return XST_SUCCESS;
+}
+
+/* seq NAME [N] | add MASK US | clear | dump [N] */
+static int CmdSeq(void *Ref, int Argc, char *Argv[])
+{
+	u32 Mask;
+	u32 Us;
+	u32 n = 1;
+
+	if (strcmp(Argv[1], "add") == 0) {
+		if (Argc < 4) return BadArg(Argv[1]);
+		if (!ParseU32(Argv[2], &Mask) || Mask > RELAY_ALL) return BadArg(Argv[2]);
+		if (!ParseU32(Argv[3], &Us)) return BadArg(Argv[3]);
+		if (RelaySeq_Add((u8)Mask, Us) != XST_SUCCESS) {
+			xil_printf("ERR sequence full (%d steps)\r\n", RELAY_SEQ_MAX_STEPS);
+			return XST_FAILURE;
+		}
+		return XST_SUCCESS;
+	}
+	if (strcmp(Argv[1], "clear") == 0) {
+		RelaySeq_Clear();
+		return XST_SUCCESS;
+	}
+	if (Argc > 2 && !ParseU32(Argv[2], &n)) return BadArg(Argv[2]);
+	if (strcmp(Argv[1], "dump") == 0) {
+		RelaySeq_Dump(Argc > 2 ? n : 0);
+		return XST_SUCCESS;
+	}
+	if (RelaySeq_Select(Argv[1]) != XST_SUCCESS) return BadArg(Argv[1]);
+	Fixture_RelaySequence(Ref, n);
+	return XST_SUCCESS;
+}
+
+static int CmdCapture(void *Ref, int Argc, char *Argv[])
+{
+	u32 Ms;
+
+	(void)Argc;
+	if (!ParseU32(Argv[1], &Ms) || Ms > FIXTURE_CAPTURE_MAX_MS) return BadArg(Argv[1]);
+	Fixture_Capture(Ref, Ms);
+	return XST_SUCCESS;
+}
+
+/* soak N [SEED] | dump [N] */
+static int CmdSoak(void *Ref, int Argc, char *Argv[])
+{
+	u32 Seed = 0;
+	u32 n = 0;
+
+	if (strcmp(Argv[1], "dump") == 0) {
+		if (Argc > 2 && !ParseU32(Argv[2], &n)) return BadArg(Argv[2]);
+		Soak_Dump(&Soak, n);
+		return XST_SUCCESS;
+	}
+	if (!ParseU32(Argv[1], &n)) return BadArg(Argv[1]);
+	if (Argc > 2 && !ParseU32(Argv[2], &Seed)) return BadArg(Argv[2]);
+	Fixture_Soak(Ref, n, Seed);
+	return XST_SUCCESS;
+}
+
+/* stats [clear|every MS]: print the selected fixture's window */
+static int CmdStats(void *Ref, int Argc, char *Argv[])
+{
+	u32 Ms;
+
+	if (Argc > 1 && strcmp(Argv[1], "clear") == 0) {
+		Stats_Clear();
+		return XST_SUCCESS;
+	}
+	if (Argc > 1) {
+		if (strcmp(Argv[1], "every") != 0) return BadArg(Argv[1]);
+		if (Argc < 3 || !ParseU32(Argv[2], &Ms) || Stats_SetPeriod(Ms) != XST_SUCCESS) {
+			return BadArg(Argc < 3 ? Argv[1] : Argv[2]);
+		}
+		return XST_SUCCESS;
+	}
+	Stats_Print(Ref);
+	return XST_SUCCESS;
+}
+
+/* dump [all|error|frame|command|coil|timeout] [N] */
+static int CmdDump(void *Ref, int Argc, char *Argv[])
+{
+	static const char *const Filters[] = { "all", "error", "frame", "command", "coil", "timeout", NULL };
+	static const u8 Bits[] = { TRACE_ALL, TRACE_ANY_ERROR, TRACE_FRAME_ERROR,
+			TRACE_COMMAND_ERROR, TRACE_COIL_ERROR, TRACE_TIMEOUT };
+	u32 Count = 0;
+	int Arg = 1;
+	int i = 0;
+
+	(void)Ref;
+	if (Arg < Argc && !ParseU32(Argv[Arg], &Count)) {
+		i = Lookup(Argv[Arg], Filters);
+		if (i < 0) return BadArg(Argv[Arg]);
+		Arg++;
+	}
+	if (Arg < Argc && !ParseU32(Argv[Arg], &Count)) return BadArg(Argv[Arg]);
+	Trace_Dump(Bits[i], Count);
+	return XST_SUCCESS;
+}
+
+static int CmdKeys(void *Ref, int Argc, char *Argv[])
+{
+	Fixture *F = Ref;
+
+	(void)Argc;
+	(void)Argv;
+	F->LineMode = 0;
+	return XST_SUCCESS;
+}
+
+static const UartCli_Command Commands[] = {
+	{ "thr",		1, CmdThr,		"17|33|84|166" },
+	{ "dw",			1, CmdDw,		"dry|wet" },
+	{ "sync",		1, CmdSync,		"on|off" },
+	{ "relays",		1, CmdRelays,	"MASK (0x01 AA .. 0x10 CC)" },
+	{ "relay",		2, CmdRelay,	"aa|ab|ca|cb|cc on|off" },
+	{ "type",		1, CmdType,		"cpldrev|change|update" },
+	{ "sh",			1, CmdSh,		"0..128" },
+	{ "reset",		1, CmdReset,	"assert|release|pulse" },
+	{ "run",		1, CmdRun,		"N (cycles, back to back, up to 1000000, Ctrl-C stops)" },
+	{ "out",		1, CmdOut,		"text|binary|delta|trace|stats|record" },
+	{ "period",		1, CmdPeriod,	"US (0 = back to back, up to 10000000)" },
+	{ "pingpong",	1, CmdPingPong,	"on|off" },
+	{ "baud",		1, CmdBaud,		"RATE" },
+	{ "fix",		1, CmdFix,		"N (fixture the console controls)" },
+	{ "sweep",		0, CmdKey,		"" },
+	{ "relaytest",	0, CmdKey,		"" },
+	{ "bench",		0, CmdKey,		"" },
+	{ "stop",		0, CmdKey,		"(leave the fixture loop)" },
+	{ "trace",		0, CmdTrace,	"[on|off|clear]" },
+	{ "dump",		0, CmdDump,		"[all|error|frame|command|coil|timeout] [N (newest, 0 all)]" },
+	{ "seq",		1, CmdSeq,		"endurance|walk|user [N] | add MASK US | clear | dump [N]" },
+	{ "capture",	1, CmdCapture,	"MS (contact input edges, up to 600000, Ctrl-C stops)" },
+	{ "soak",		1, CmdSoak,		"N [SEED] (random frames vs. model) | dump [N]" },
+	{ "stats",		0, CmdStats,	"[clear|every MS]" },
+	{ "keys",		0, CmdKeys,		"(back to single-key controls)" },
+	{ NULL,			0, NULL,		NULL },
+};
+
+/****************************************************************************/
+/**
+*
+* Run one command line, see Commands[] and UartCli_Execute() for the syntax.
+*
+* @param	F is the fixture state.
+* @param	Line is the command line; it is modified.
+*
+* @return	0 if the line stopped the fixture loop, 1 otherwise.
+*
+*****************************************************************************/
+int Fixture_HandleLine(Fixture *F, char *Line)
+{
+	LinePass = 1;
+	UartCli_Execute(Commands, Line, F);
+	return LinePass;
+}
@@ -0,0 +1,256 @@
+/******************************************************************************
+* fixture.h: shared definitions for the Cora Z7 fixture application
+*
+* The fixture loop talks to the CPLD through two AXI BRAMs and an AXI GPIO
+* handshake:
+*
+*   BRAM0 (PS -> PL)  5-word COMMAND frame at offsets 0x00..0x10
+*   BRAM1 (PL -> PS)  7-word response (data1..data7) at offsets 0x00..0x18
+*   GPIO INPUT        bit 3 = WriteEn, bit 2 = ReadEn
+*   GPIO OUTPUT       bit 0 = fixture reset (0 = in reset, 1 = operating)
+*
+* Build with FIXTURE_HOST defined to target the Linux simulator backend
+* instead of the Xilinx BSP.
+******************************************************************************/
+#ifndef FIXTURE_H
+#define FIXTURE_H
+
+#ifdef FIXTURE_HOST
+#include <stdio.h>
+#include <stdint.h>
+
+typedef uint8_t		u8;
+typedef uint16_t	u16;
+typedef uint32_t	u32;
+typedef uint64_t	u64;
+typedef int16_t		s16;
+typedef int32_t		s32;
+
+#define XST_SUCCESS			0L
+#define XST_FAILURE			1L
+#define XST_NO_DATA			13L
+#define TRUE				1
+#define FALSE				0
+
+#define xil_printf			printf
+#else
+#include "xil_types.h"
+#include "xstatus.h"
+#include "xil_printf.h"
+#endif
+
+#ifndef FIXTURE_READEN_TIMEOUT_US
+#define FIXTURE_READEN_TIMEOUT_US	100000		/* Give up on a frame after 100 ms */
+#endif
+
+/* Set to 1 to wait for WriteEn before writing each COMMAND frame */
+#ifndef FIXTURE_WAIT_WRITE_EN
+#define FIXTURE_WAIT_WRITE_EN	0
+#endif
+
+/* Longest run and capture console commands; Ctrl-C stops either sooner */
+#ifndef FIXTURE_RUN_MAX
+#define FIXTURE_RUN_MAX			1000000		/* Cycles */
+#endif
+
+#ifndef FIXTURE_CAPTURE_MAX_MS
+#define FIXTURE_CAPTURE_MAX_MS	600000		/* 10 minutes */
+#endif
+
+#ifndef FIXTURE_RESET_PULSE_US
+#define FIXTURE_RESET_PULSE_US	1000000		/* Reset pulse before a CPLD revision read */
+#endif
+
+/* Per-cycle report on the console UART */
+#define OUTPUT_TEXT			0	/* Full status printout, debug view */
+#define OUTPUT_BINARY		1	/* One STREAM_RECORD_SIZE record, see status_stream.h */
+#define OUTPUT_DELTA		2	/* Rewrite only the changed status lines, see render.h */
+#define OUTPUT_TRACE		3	/* Quiet, one line per cycle with an error, see trace.h */
+#define OUTPUT_STATS		4	/* Periodic per-bit summary, see stats.h */
+#define OUTPUT_RECORD		5	/* Session record with timing for replay, see record.h */
+
+#ifndef FIXTURE_OUTPUT_DEFAULT
+#define FIXTURE_OUTPUT_DEFAULT	OUTPUT_BINARY
+#endif
+
+/////////////////////////////////// HANDSHAKE GPIO ///////////////////////////////////////////////
+#define HS_WRITE_EN			0x8
+#define HS_READ_EN			0x4
+
+#define RESET_ASSERT		0x00000000
+#define RESET_RELEASE		0x00000001
+
+/////////////////////////////////// COMMAND FRAME ////////////////////////////////////////////////
+#define CMD_WORDS			5
+#define RSP_WORDS			7
+
+#define FRAME_HEADER		0x00007E09		// HEADER = 0x7E	// POS = "000" // BOARD_ID = "1001"
+#define FRAME_COMMAND3		0x00004000		// See COMMAND Frame
+#define FRAME_FOOTER		0x0000007E		// FOOTER = 0x7E
+
+#define POS_Pos				4		// Command1 bits 6:4, fixture position
+#define POS_BoardId			0		// Command1 bits 3:0
+#define Board_Id			0x9		//"1001"
+
+#define POS_CommandType		14
+#define ChangeRequest		0x1		//"01"
+#define DataUpdate			0x2		//"10"
+#define CPLDRev				0x0		//"00"
+
+#define POS_ModId			12
+#define Mod_Id				0x3 	//"11"
+
+#define POS_Threshold		10
+#define Threshold_17V		0x3		//"11"
+#define Threshold_33V		0x2		//"10"
+#define Threshold_84V		0x1		//"01"
+#define Threshold_166V		0x0		//"00"
+
+#define POS_DryWet			9
+#define Dry					0x1		//"1"
+#define Wet					0x0		//"0"
+
+#define POS_Synch			8
+#define Synch				0x1		//"1"
+#define NoSynch				0x0		//"0"
+
+#define POS_ShNum			7
+#define SHNUM_WRAP			128
+
+#define RELAY_AA			0x01
+#define RELAY_AB			0x02
+#define RELAY_CA			0x04
+#define RELAY_CB			0x08
+#define RELAY_CC			0x10
+#define RELAY_ALL			0x1F
+
+/////////////////////////////////// PING-PONG STAGING ////////////////////////////////////////////
+/*
+ * With BRAM_MODE_PINGPONG written to BRAM0_MODE_OFFSET, BRAM0 holds two COMMAND
+ * slots at PP_SLOT_STRIDE apart and the CPLD serves them in the order their
+ * FOOTERs were written. WriteEn is high while a slot is free to be staged. The
+ * response to the frame in BRAM0 slot s goes to BRAM1 slot s, followed by the
+ * running response count (low 16 bits) at PP_DONE_OFFSET of that slot, and
+ * ReadEn toggles once per posted response.
+ */
+#define BRAM0_MODE_OFFSET	0x40
+#define BRAM_MODE_SINGLE	0
+#define BRAM_MODE_PINGPONG	1
+
+#define PP_SLOTS			2
+#define PP_SLOT_STRIDE		0x20
+#define PP_DONE_OFFSET		0x1C
+
+#ifndef FIXTURE_PINGPONG
+#define FIXTURE_PINGPONG	0
+#endif
+
+/////////////////////////////////// COMMAND RING /////////////////////////////////////////////////
+/*
+ * With BRAM_MODE_RING written to BRAM0_MODE_OFFSET, BRAM0 holds RING_SLOTS
+ * COMMAND frames from RING_BASE_OFFSET on, PP_SLOT_STRIDE apart, and BRAM1 the
+ * responses in the same slots. The PS writes the free-running count of posted
+ * frames to RING_HEAD_OFFSET of BRAM0; the CPLD serves frames in order and
+ * writes the count of consumed frames to RING_TAIL_OFFSET of BRAM1. Each
+ * response carries that count (low 16 bits) at PP_DONE_OFFSET, so a slot whose
+ * stamp is not its frame index + 1 was never answered. Writing the mode
+ * register resets both counts and the stamps to 0.
+ */
+#define BRAM_MODE_RING		2
+
+#define RING_HEAD_OFFSET	0x44		/* BRAM0, written by the PS */
+#define RING_TAIL_OFFSET	0x44		/* BRAM1, written by the CPLD */
+#define RING_BASE_OFFSET	0x100
+#define RING_SLOTS			32			/* Power of two */
+#define RING_SLOT(Index)	(RING_BASE_OFFSET / PP_SLOT_STRIDE + ((Index) & (RING_SLOTS - 1)))
+
+/////////////////////////////////// RESPONSE (data2) /////////////////////////////////////////////
+#define RSP_FRAME_ERROR		0x00008000
+#define RSP_COMMAND_ERROR	0x00005000		// Text view test of the base application, with COIL ERROR
+#define RSP_COMMAND_ERROR_BIT	0x00004000	// COMMAND ERROR alone
+#define RSP_12V_RLY_OFF		0x00002000
+#define RSP_COIL_ERROR		0x00001000
+#define RSP_THRESHOLD_MASK	0x00000C00
+#define RSP_THRESHOLD_17V	0x00000C00
+#define RSP_THRESHOLD_33V	0x00000400
+#define RSP_THRESHOLD_84V	0x00000800
+#define RSP_THRESHOLD_166V	0x00000000
+#define RSP_DRY				0x00000200
+#define RSP_SYNCH			0x00000100
+
+#define RSP_RELAY_MASK		0x0000001F		// data3
+#define RSP_INPUT_MASK		0x0000007F		// data4
+
+/////////////////////////////////// FIXTURE STATE ////////////////////////////////////////////////
+/* Commanded state, encoded into Command1..Command3 by BramCmd_BuildFrame() */
+typedef struct {
+	u32 Pos;				/* Command1 POS, one per fixture of a station */
+	u32 BoardId;
+	u32 CommandType;
+	u32 ModId;
+	u32 Threshold;
+	u32 DryWet;
+	u32 Synchronization;
+	u32 Relays;				/* RELAY_AA..RELAY_CC bitmask */
+} FixtureConfig;
+
+/* COMMAND frames for every SHnum of one configuration */
+typedef struct {
+	FixtureConfig Config;	/* Configuration the frames were built for */
+	int Valid;
+	u32 Frame[SHNUM_WRAP + 1][CMD_WORDS];
+} FrameCache;
+
+/* One in-flight frame of ping-pong mode */
+typedef struct {
+	u32 Command[CMD_WORDS];
+	u64 Written;			/* Time_Now() at the FOOTER write */
+	u16 Count;				/* Response count that completes it */
+} StagedFrame;
+
+typedef struct {
+	FixtureConfig Config;
+	FrameCache Cache;
+	u32 Reset;				/* Level driven on the OUTPUT GPIO */
+	u8 SHnum;				/* Sample and Hold number */
+	u8 OutputMode;			/* OUTPUT_TEXT, OUTPUT_BINARY or OUTPUT_DELTA */
+	u8 LineMode;			/* Console takes command lines instead of keys */
+	u16 Seq;				/* Handshake cycles since start-up */
+
+	u32 Command[CMD_WORDS];	/* Last frame written to BRAM0 */
+	u32 Data[RSP_WORDS];	/* Last response read from BRAM1 */
+	u64 Finished;			/* Time_Now() when the response was taken */
+	u32 CpldRev1;			/* CPLD_REV MM-DD */
+	u32 CpldRev2;			/* CPLD_REV YY-RR */
+
+	int Status;				/* XST_SUCCESS, or XST_FAILURE on handshake timeout */
+	u32 TurnaroundUs;		/* Last FOOTER write to ReadEn */
+	u32 TurnaroundMaxUs;
+	u32 Timeouts;			/* Handshake timeouts since start-up */
+
+	u8 PingPong;			/* Stage frame N+1 while the CPLD runs frame N */
+	u32 Issued;				/* Ping-pong frames staged */
+	u32 Completed;			/* Ping-pong frames collected or abandoned */
+	u16 NextCount;			/* Response count of the next staged frame */
+	StagedFrame Staged[PP_SLOTS];
+} Fixture;
+
+void Fixture_Init(Fixture *F);
+void Fixture_Start(Fixture *F);
+int Fixture_Cycle(Fixture *F);
+void Fixture_Stage(Fixture *F);
+void Fixture_Complete(Fixture *F, const u32 *Response, u64 Written);
+void Fixture_Replay(Fixture *F, const u32 *Command, const u32 *Response, int Status,
+		u32 TurnaroundUs);
+void Fixture_SetPingPong(Fixture *F, int Enable);
+void Fixture_RelayTest(Fixture *F);
+void Fixture_RelaySequence(Fixture *F, u32 Repeat);
+void Fixture_Capture(Fixture *F, u32 DurationMs);
+void Fixture_Soak(Fixture *F, u32 Cycles, u32 Seed);
+void Fixture_Sweep(Fixture *F);
+void Fixture_BramBenchmark(Fixture *F, u32 Frames);
+void Fixture_Report(const Fixture *F);
+int Fixture_HandleKey(Fixture *F, u8 Key);
+int Fixture_HandleLine(Fixture *F, char *Line);
+
+#endif
@@ -0,0 +1,65 @@
+/******************************************************************************
+* fmt.c: allocation-free text formatting for the fixture views
+******************************************************************************/
+#include <string.h>
+#include "fmt.h"
+#include "uart_cli.h"
+
+static const char HexDigit[16] = "0123456789ABCDEF";
+
+FmtBuf Fmt_View;
+
+void Fmt_Append(FmtBuf *B, const char *Str, u32 Len)
+{
+	if (Len > FMT_BUF_SIZE - B->Len) {
+		Len = FMT_BUF_SIZE - B->Len;
+	}
+	memcpy(&B->Buf[B->Len], Str, Len);
+	B->Len += Len;
+}
+
+void Fmt_Text(FmtBuf *B, const FmtText *Text)
+{
+	Fmt_Append(B, Text->Str, Text->Len);
+}
+
+void Fmt_Str(FmtBuf *B, const char *Str)
+{
+	Fmt_Append(B, Str, strlen(Str));
+}
+
+/*
+ * Four upper-case hex digits, the "%04X" of the base application, by table
+ * lookup of each nibble.
+ */
+void Fmt_Hex4(FmtBuf *B, u32 Value)
+{
+	char Digits[4];
+
+	Digits[0] = HexDigit[(Value >> 12) & 0xF];
+	Digits[1] = HexDigit[(Value >> 8) & 0xF];
+	Digits[2] = HexDigit[(Value >> 4) & 0xF];
+	Digits[3] = HexDigit[Value & 0xF];
+	Fmt_Append(B, Digits, 4);
+}
+
+void Fmt_Dec(FmtBuf *B, u32 Value)
+{
+	char Digits[10];
+	u32 n = sizeof(Digits);
+
+	do {
+		Digits[--n] = (char)('0' + Value % 10);
+		Value /= 10;
+	} while (Value != 0);
+	Fmt_Append(B, &Digits[n], sizeof(Digits) - n);
+}
+
+/*
+ * Queue the buffered text for the UART and empty the buffer.
+ */
+void Fmt_Flush(FmtBuf *B)
+{
+	UartCli_Write((const u8 *)B->Buf, B->Len);
+	B->Len = 0;
+}
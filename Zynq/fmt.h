@@ -0,0 +1,45 @@
+/******************************************************************************
+* fmt.h: allocation-free text formatting for the fixture views
+*
+* The status views are mostly constant strings plus 16-bit hex fields, so
+* instead of parsing a format string per line with xil_printf, they append
+* precomputed strings (FmtText, length known at compile time) and fixed-width
+* hex digits to a FmtBuf, then hand the whole view to the UART in one
+* UartCli_Write().
+*
+* A FmtBuf that runs out of room drops what does not fit.
+******************************************************************************/
+#ifndef FMT_H
+#define FMT_H
+
+#include "fixture.h"
+
+#define FMT_BUF_SIZE		2048	/* One full text view */
+
+typedef struct {
+	const char *Str;
+	u32 Len;
+} FmtText;
+
+/* FmtText initializer for a string literal */
+#define FMT_TEXT(Literal)	{ Literal, sizeof(Literal) - 1 }
+
+typedef struct {
+	char Buf[FMT_BUF_SIZE];
+	u32 Len;
+} FmtBuf;
+
+/* Buffer of the text and delta views, which never format at the same time */
+extern FmtBuf Fmt_View;
+
+void Fmt_Text(FmtBuf *B, const FmtText *Text);
+void Fmt_Str(FmtBuf *B, const char *Str);
+void Fmt_Hex4(FmtBuf *B, u32 Value);
+void Fmt_Dec(FmtBuf *B, u32 Value);
+void Fmt_Flush(FmtBuf *B);
+
+/* Append a string literal */
+#define Fmt_Lit(B, Literal)	Fmt_Append(B, Literal, sizeof(Literal) - 1)
+void Fmt_Append(FmtBuf *B, const char *Str, u32 Len);
+
+#endif
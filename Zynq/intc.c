@@ -0,0 +1,81 @@
+/******************************************************************************
+* intc.c: GIC set-up shared by the interrupt-driven drivers
+******************************************************************************/
+#include "intc.h"
+
+#ifndef FIXTURE_HOST
+#include "xparameters.h"
+#include "xscugic.h"
+#include "xil_exception.h"
+
+#define INTC_DEVICE_ID		XPAR_SCUGIC_SINGLE_DEVICE_ID
+
+static XScuGic Gic;
+
+int Intc_Init(void)
+{
+	XScuGic_Config *ConfigPtr;
+	int Status;
+
+	if (Gic.IsReady == XIL_COMPONENT_IS_READY) {
+		return XST_SUCCESS;
+	}
+
+	ConfigPtr = XScuGic_LookupConfig(INTC_DEVICE_ID);
+	if (ConfigPtr == NULL) {
+		return XST_FAILURE;
+	}
+
+	Status = XScuGic_CfgInitialize(&Gic, ConfigPtr, ConfigPtr->CpuBaseAddress);
+	if (Status != XST_SUCCESS) {
+		return XST_FAILURE;
+	}
+
+	Xil_ExceptionInit();
+	Xil_ExceptionRegisterHandler(XIL_EXCEPTION_ID_INT,
+			(Xil_ExceptionHandler)XScuGic_InterruptHandler, &Gic);
+	Xil_ExceptionEnable();
+
+	return XST_SUCCESS;
+}
+
+int Intc_Connect(u32 IntrId, Intc_Handler Handler, void *CallBackRef)
+{
+	int Status;
+
+	Status = XScuGic_Connect(&Gic, IntrId, (Xil_InterruptHandler)Handler, CallBackRef);
+	if (Status != XST_SUCCESS) {
+		return XST_FAILURE;
+	}
+	XScuGic_Enable(&Gic, IntrId);
+
+	return XST_SUCCESS;
+}
+
+void Intc_Disconnect(u32 IntrId)
+{
+	XScuGic_Disable(&Gic, IntrId);
+	XScuGic_Disconnect(&Gic, IntrId);
+}
+
+#else /* FIXTURE_HOST */
+
+int Intc_Init(void)
+{
+	return XST_SUCCESS;
+}
+
+int Intc_Connect(u32 IntrId, Intc_Handler Handler, void *CallBackRef)
+{
+	(void)IntrId;
+	(void)Handler;
+	(void)CallBackRef;
+	return XST_SUCCESS;
+}
+
+void Intc_Disconnect(u32 IntrId)
+{
+	(void)IntrId;
+}
+
+#endif
@@ -0,0 +1,18 @@
+/******************************************************************************
+* intc.h: GIC set-up shared by the interrupt-driven drivers
+*
+* On the host build there is no interrupt controller; Intc_Init() succeeds
+* and the host backends poll instead.
+******************************************************************************/
+#ifndef INTC_H
+#define INTC_H
+
+#include "fixture.h"
+
+typedef void (*Intc_Handler)(void *CallBackRef);
+
+int Intc_Init(void);
+int Intc_Connect(u32 IntrId, Intc_Handler Handler, void *CallBackRef);
+void Intc_Disconnect(u32 IntrId);
+
+#endif
@@ -1,2 +1,119 @@
+/******************************************************************************
+* main.c: Cora Z7 fixture application
+*
+* Same console flow as the base application: type '1' to start the fixture
+* loop, '0' to stop it, and the single-key controls handled by
+* Fixture_HandleKey() while it runs. While running, each cycle is reported as
+* a binary record (see status_stream.h); 't' cycles through the text debug
+* view, the delta-only status view (see render.h) and back to binary.
+*
+* Cycles start every FIXTURE_CYCLE_PERIOD_US on the private timer (see
+* sched.h); '+' halves and '-' doubles the period. 'w' toggles ping-pong
+* staging of BRAM0 (see fixture.h); while the pipeline fills there is
+* nothing to report. 'q' runs the relay test sequence through the command
+* ring (see cmd_queue.h), 'm' a full SHnum sweep (see sweep.h). With
+* FIXTURE_PROFILE, 'i' dumps and resets the per-phase counts (see prof.h).
+* 'c' switches to command lines ("thr 84", "run 1000", macros; 'help' lists
+* them, see Fixture_HandleLine() and uart_cli.h). With FIXTURE_COUNT > 1, 'n'
+* moves the console to the next fixture of the station (see station.h).
+******************************************************************************/
+#if !defined(FIXTURE_BENCH) && !defined(FIXTURE_REPLAY)	/* bench_host.c, replay_host.c have their own */
+#include "fixture.h"
+#include "bram_cmd.h"
+#include "station.h"
+#include "uart_cli.h"
+#include "sched.h"
+#include "prof.h"
+#include "timebase.h"
 
+#ifndef FIXTURE_HOST
+#include "platform.h"
+#else
+#define init_platform()
+#define cleanup_platform()
+#endif
 
+int main()
+{
+	int Status;
+	int pass = 0;
+	u8 recv_char;
+
+	init_platform();
+
+	xil_printf("HELLO WORLD\r\n");
+	UartCli_Init(UART_BAUD_RATE);
+
+	Status = BramCmd_Init();
+	if (Status != XST_SUCCESS) {
+		return XST_FAILURE;
+	}
+
+	Status = Sched_Init(FIXTURE_CYCLE_PERIOD_US);
+	if (Status != XST_SUCCESS) {
+		xil_printf("Cycle timer init failed\r\n");
+		return XST_FAILURE;
+	}
+
+	Station_Init();
+#if FIXTURE_PROFILE
+	Prof_Init();
+#endif
+	xil_printf("Ready %d us after reset\r\n", Time_SinceResetUs());
+
+	while (UartCli_IsOpen()) {
+		xil_printf("Enter a character: ");
+		while (UartCli_IsReceiveData() == FALSE) {
+			if (!UartCli_IsOpen()) break;
+			Sched_Idle(UartCli_IsReceiveData);
+		}
+		xil_printf("\r\n");
+
+		while (!pass && UartCli_IsOpen()) {
+			recv_char = UartCli_RecvByte();
+			xil_printf("You typed: %c\r\n", recv_char);
+
+			if (recv_char != '1') {
+				xil_printf("Please type 1 to continue: \r\n");
+				pass = 0;
+			}
+			else {
+				pass = 1;
+				xil_printf("\x1b[2J"); // Clear screen
+				xil_printf("\x1b[H");  // Move cursor to top-left (home)
+			}
+		}
+
+		Station_Start();
+		Sched_SetPeriod(Sched_Period());
+
+		while (pass) {
+			PROF_BEGIN(PROF_IDLE);
+			Sched_WaitNextCycle();
+			PROF_END(PROF_IDLE);
+
+			PROF_BEGIN(PROF_CYCLE);
+			Status = Station_Cycle();
+			PROF_END(PROF_CYCLE);
+
+			if (Status != XST_NO_DATA) {
+				PROF_BEGIN(PROF_REPORT);
+				Station_Report();
+				PROF_END(PROF_REPORT);
+			}
+
+			PROF_BEGIN(PROF_KEYS);
+			pass = Station_PollInput();
+			PROF_END(PROF_KEYS);
+			if (!UartCli_IsOpen()) {
+				pass = 0;
+			}
+		}
+	}
+
+	cleanup_platform();
+	xil_printf("Bram Test done\r\n");
+	return 0;
+}
+
+#endif /* FIXTURE_BENCH, FIXTURE_REPLAY */
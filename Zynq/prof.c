@@ -0,0 +1,152 @@
+/******************************************************************************
+* prof.c: per-phase cycle counts of the fixture loop
+******************************************************************************/
+#ifdef FIXTURE_HOST
+#define _POSIX_C_SOURCE 200809L
+#include <time.h>
+#endif
+
+#include "prof.h"
+
+#if FIXTURE_PROFILE
+
+typedef struct {
+	u32 Count;
+	u64 Min;
+	u64 Max;
+	u64 Sum;
+	u32 Hist[PROF_BUCKETS];
+} PhaseStats;
+
+static const char *PhaseName[PROF_PHASES] = {
+	"cycle", "write", "readen", "read", "report", "keys", "idle",
+};
+
+u64 Prof_Start[PROF_PHASES];
+static PhaseStats Stats[PROF_PHASES];
+
+#ifdef FIXTURE_HOST
+u64 Prof_Now(void)
+{
+	struct timespec Now;
+
+	clock_gettime(CLOCK_MONOTONIC, &Now);
+	return (u64)Now.tv_sec * 1000000000ull + (u64)Now.tv_nsec;
+}
+
+void Prof_Init(void)
+{
+	Prof_Reset();
+}
+#else
+#include "xparameters.h"
+#include "xtime_l.h"
+
+/*
+ * Enable and reset the PMU cycle counter: PMCR.E and PMCR.C, then the cycle
+ * counter bit of PMCNTENSET. PMCR.D stays clear, so it counts every cycle.
+ */
+void Prof_Init(void)
+{
+	mtcp(XREG_CP15_PERF_MONITOR_CTRL, 0x5);
+	mtcp(XREG_CP15_COUNT_ENABLE_SET, 0x80000000);
+	Prof_Reset();
+}
+
+#define PROF_CYCLES_PER_TICK	(XPAR_CPU_CORTEXA9_0_CPU_CLK_FREQ_HZ / COUNTS_PER_SECOND)
+
+u64 Prof_Coarse[PROF_PHASES];
+
+/*
+ * Finish Phase at PMCCNTR value Now. The low 32 bits of the count come from
+ * PMCCNTR; the global timer span, a little longer since it brackets the
+ * PMCCNTR reads, says how many times PMCCNTR wrapped in between.
+ */
+void Prof_End(u32 Phase, u32 Now)
+{
+	u64 Coarse = (Time_Now() - Prof_Coarse[Phase]) * PROF_CYCLES_PER_TICK;
+	u32 Fine = Now - (u32)Prof_Start[Phase];
+
+	Prof_Record(Phase, Fine + ((Coarse - Fine + 0x80000000ull) & ~0xFFFFFFFFull));
+}
+#endif
+
+void Prof_Record(u32 Phase, u64 Count)
+{
+	PhaseStats *S = &Stats[Phase];
+	u32 Bucket = Count ? 63 - __builtin_clzll(Count) : 0;
+
+	if (S->Count == 0 || Count < S->Min) S->Min = Count;
+	if (Count > S->Max) S->Max = Count;
+	S->Count++;
+	S->Sum += Count;
+	S->Hist[Bucket < PROF_BUCKETS ? Bucket : PROF_BUCKETS - 1]++;
+}
+
+/* xil_printf has no 64-bit conversion: counts from 2^31 up print in thousands */
+static void PrintCount(const char *Name, u64 Count)
+{
+	if (Count < 0x80000000ull) {
+		xil_printf(" %s=%d", Name, (u32)Count);
+	}
+	else {
+		xil_printf(" %s=%dk", Name, (u32)(Count / 1000));
+	}
+}
+
+void Prof_Reset(void)
+{
+	u32 p;
+	u32 b;
+
+	for (p = 0; p < PROF_PHASES; p++) {
+		Stats[p].Count = 0;
+		Stats[p].Min = 0;
+		Stats[p].Max = 0;
+		Stats[p].Sum = 0;
+		for (b = 0; b < PROF_BUCKETS; b++) {
+			Stats[p].Hist[b] = 0;
+		}
+	}
+}
+
+/****************************************************************************/
+/**
+*
+* Print count, min, max and mean of every phase that ran, followed by its
+* non-empty log2 histogram buckets as "2^n:count", the last one as
+* "2^31+:count".
+*
+* @param	None.
+*
+* @return	None.
+*
+*****************************************************************************/
+void Prof_Dump(void)
+{
+	PhaseStats *S;
+	u32 p;
+	u32 b;
+
+	xil_printf("PROFILE (%s):\r\n", PROF_UNIT);
+	for (p = 0; p < PROF_PHASES; p++) {
+		S = &Stats[p];
+		if (S->Count == 0) {
+			continue;
+		}
+		xil_printf("  %-7s n=%d", PhaseName[p], S->Count);
+		PrintCount("min", S->Min);
+		PrintCount("max", S->Max);
+		PrintCount("mean", S->Sum / S->Count);
+		xil_printf("\r\n");
+		xil_printf("         ");
+		for (b = 0; b < PROF_BUCKETS; b++) {
+			if (S->Hist[b]) {
+				xil_printf(b < PROF_BUCKETS - 1 ? " 2^%d:%d" : " 2^%d+:%d", b, S->Hist[b]);
+			}
+		}
+		xil_printf("\r\n");
+	}
+}
+
+#endif /* FIXTURE_PROFILE */
@@ -0,0 +1,69 @@
+/******************************************************************************
+* prof.h: per-phase cycle counts of the fixture loop
+*
+* PROF_BEGIN(Phase)/PROF_END(Phase) bracket one phase of a cycle. Each phase
+* keeps its count, min, max, sum and a log2 histogram in static memory;
+* Prof_Dump() prints them and Prof_Reset() clears them.
+*
+* On the board the unit is CPU cycles from the Cortex-A9 PMU cycle counter
+* (PMCCNTR), on the host nanoseconds from CLOCK_MONOTONIC. PMCCNTR is 32 bits
+* and wraps every 6.4 s at 667 MHz, shorter than the longest idle phase, so
+* the global timer is read around it as well and supplies the whole wraps.
+* Counts are 64-bit; the last histogram bucket takes everything from 2^31 up.
+* Without FIXTURE_PROFILE the macros expand to nothing and prof.c is empty.
+******************************************************************************/
+#ifndef PROF_H
+#define PROF_H
+
+#include "fixture.h"
+
+#ifndef FIXTURE_PROFILE
+#define FIXTURE_PROFILE		0
+#endif
+
+#define PROF_CYCLE			0	/* Whole Fixture_Cycle() */
+#define PROF_WRITE			1	/* Frame lookup and BRAM0 write */
+#define PROF_READEN			2	/* Wait for ReadEn or the response count */
+#define PROF_READ			3	/* BRAM1 read */
+#define PROF_REPORT			4	/* Status encode/format and UART queueing */
+#define PROF_KEYS			5	/* Key handling */
+#define PROF_IDLE			6	/* Waiting for the next cycle period */
+#define PROF_PHASES			7
+
+#define PROF_BUCKETS		32	/* Bucket n counts values in [2^n, 2^(n+1)), the last from 2^31 up */
+
+#if FIXTURE_PROFILE
+extern u64 Prof_Start[PROF_PHASES];
+
+#ifdef FIXTURE_HOST
+u64 Prof_Now(void);
+#define PROF_UNIT			"ns"
+
+#define PROF_BEGIN(Phase)	(Prof_Start[Phase] = Prof_Now())
+#define PROF_END(Phase)		Prof_Record(Phase, Prof_Now() - Prof_Start[Phase])
+#else
+#include "xpseudo_asm.h"
+#include "xreg_cortexa9.h"
+#include "timebase.h"
+#define Prof_Now()			((u32)mfcp(XREG_CP15_PERF_CYCLE_COUNTER))
+#define PROF_UNIT			"cycles"
+
+extern u64 Prof_Coarse[PROF_PHASES];
+
+/* The global timer is read outside the PMCCNTR span, so it adds no cost */
+#define PROF_BEGIN(Phase)	(Prof_Coarse[Phase] = Time_Now(), Prof_Start[Phase] = Prof_Now())
+#define PROF_END(Phase)		Prof_End(Phase, Prof_Now())
+
+void Prof_End(u32 Phase, u32 Now);
+#endif
+
+void Prof_Init(void);
+void Prof_Record(u32 Phase, u64 Count);
+void Prof_Reset(void);
+void Prof_Dump(void);
+#else
+#define PROF_BEGIN(Phase)
+#define PROF_END(Phase)
+#endif
+
+#endif
@@ -0,0 +1,115 @@
+/******************************************************************************
+* record.c: session recording, one binary record per handshake cycle
+******************************************************************************/
+#include "record.h"
+#include "status_stream.h"
+#include "uart_cli.h"
+#include "timebase.h"
+
+static u64 LastFinished;
+static int Started;
+
+static u8 *Put16(u8 *Buf, u32 Value)
+{
+	Buf[0] = (u8)Value;
+	Buf[1] = (u8)(Value >> 8);
+	return Buf + 2;
+}
+
+static u8 *Put32(u8 *Buf, u32 Value)
+{
+	return Put16(Put16(Buf, Value), Value >> 16);
+}
+
+static u32 Get16(const u8 *Buf)
+{
+	return (u32)Buf[0] | ((u32)Buf[1] << 8);
+}
+
+/*
+ * Start a new session: the next record has a delta time of 0.
+ */
+void Record_Start(void)
+{
+	Started = 0;
+}
+
+/****************************************************************************/
+/**
+*
+* Encode the last frame of F, with the time since the previously encoded
+* frame, into one session record.
+*
+* @param	F is the fixture state after its frame finished.
+* @param	Buf receives RECORD_SIZE bytes.
+*
+* @return	Number of bytes written, RECORD_SIZE.
+*
+*****************************************************************************/
+u32 Record_Encode(const Fixture *F, u8 *Buf)
+{
+	u64 DeltaUs = Started ? Time_TicksToUs(F->Finished - LastFinished) : 0;
+	u8 *p = Buf;
+	int i;
+
+	LastFinished = F->Finished;
+	Started = 1;
+
+	*p++ = RECORD_SYNC0;
+	*p++ = RECORD_SYNC1;
+	p = Put16(p, (u16)(F->Seq - 1));
+	p = Put32(p, DeltaUs > 0xFFFFFFFF ? 0xFFFFFFFF : (u32)DeltaUs);
+	p = Put16(p, F->TurnaroundUs > 0xFFFF ? 0xFFFF : F->TurnaroundUs);
+	*p++ = (u8)((F->Reset ? RECORD_FLAG_RESET : 0) |
+			(F->Status != XST_SUCCESS ? RECORD_FLAG_TIMEOUT : 0));
+	*p++ = RECORD_VERSION;
+	for (i = 0; i < CMD_WORDS; i++) {
+		p = Put16(p, F->Command[i]);
+	}
+	for (i = 0; i < RSP_WORDS; i++) {
+		p = Put16(p, F->Data[i]);
+	}
+	p = Put16(p, Stream_Crc16(Buf + 2, (u32)(p - Buf) - 2));
+
+	return (u32)(p - Buf);
+}
+
+void Record_Send(const Fixture *F)
+{
+	u8 Record[RECORD_SIZE];
+
+	UartCli_Send(Record, Record_Encode(F, Record));
+}
+
+/****************************************************************************/
+/**
+*
+* Decode one session record.
+*
+* @param	Buf holds RECORD_SIZE bytes starting at the sync bytes.
+* @param	R receives the fields.
+*
+* @return	XST_SUCCESS, or XST_FAILURE if the sync, version or CRC is wrong.
+*
+*****************************************************************************/
+int Record_Decode(const u8 *Buf, RecordFrame *R)
+{
+	const u8 *p = Buf + 12;
+	int i;
+
+	if (Buf[0] != RECORD_SYNC0 || Buf[1] != RECORD_SYNC1 || Buf[11] != RECORD_VERSION ||
+			Get16(Buf + RECORD_SIZE - 2) != Stream_Crc16(Buf + 2, RECORD_SIZE - 4)) {
+		return XST_FAILURE;
+	}
+	R->Seq = (u16)Get16(Buf + 2);
+	R->DeltaUs = Get16(Buf + 4) | (Get16(Buf + 6) << 16);
+	R->TurnaroundUs = Get16(Buf + 8);
+	R->Flags = Buf[10];
+	for (i = 0; i < CMD_WORDS; i++, p += 2) {
+		R->Command[i] = Get16(p);
+	}
+	for (i = 0; i < RSP_WORDS; i++, p += 2) {
+		R->Data[i] = Get16(p);
+	}
+	return XST_SUCCESS;
+}
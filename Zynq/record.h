@@ -0,0 +1,51 @@
+/******************************************************************************
+* record.h: session recording, one binary record per handshake cycle
+*
+* The OUTPUT_RECORD mode sends every finished frame with its timing, for
+* replay_host.c to feed back through the same views and statistics on Linux.
+* Record layout, all multi-byte fields little-endian:
+*
+*   Offset  Size  Field
+*   0       2     Sync 0xA5 0x5C
+*   2       2     Seq of the fixture, incremented every cycle (wraps at 65536)
+*   4       4     Microseconds since the previous record (0 for the first)
+*   8       2     Turnaround in microseconds, FOOTER write to ReadEn (saturates)
+*   10      1     Flags: bit 2 reset released, bit 3 handshake timeout
+*   11      1     Format version, RECORD_VERSION
+*   12      10    Command1..Command5 (low 16 bits each, POS in Command1)
+*   22      14    data1..data7
+*   36      2     CRC-16/CCITT-FALSE over bytes 2..35
+*
+* A session is just the records as received, e.g. the console UART captured
+* to a file. Records that do not fit the TX ring are dropped, which shows up
+* as a Seq gap; anything between records (console echo) is skipped on replay.
+******************************************************************************/
+#ifndef RECORD_H
+#define RECORD_H
+
+#include "fixture.h"
+
+#define RECORD_SYNC0			0xA5
+#define RECORD_SYNC1			0x5C	/* 0x5A status record, 0x5B sweep blob */
+#define RECORD_SIZE				38
+#define RECORD_VERSION			1
+
+#define RECORD_FLAG_RESET		0x04	/* Same bits as the status stream */
+#define RECORD_FLAG_TIMEOUT		0x08
+
+/* One decoded record */
+typedef struct {
+	u16 Seq;
+	u8 Flags;
+	u32 DeltaUs;
+	u32 TurnaroundUs;
+	u32 Command[CMD_WORDS];
+	u32 Data[RSP_WORDS];
+} RecordFrame;
+
+void Record_Start(void);
+u32 Record_Encode(const Fixture *F, u8 *Buf);
+void Record_Send(const Fixture *F);
+int Record_Decode(const u8 *Buf, RecordFrame *R);
+
+#endif
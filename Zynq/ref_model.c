@@ -0,0 +1,193 @@
+/******************************************************************************
+* ref_model.c: reference model of the CPLD response
+******************************************************************************/
+#include "ref_model.h"
+
+#define REF_DATA2_CARE		(RSP_FRAME_ERROR | RSP_COMMAND_ERROR_BIT | RSP_12V_RLY_OFF | RSP_COIL_ERROR)
+#define REF_LATCHED_CARE	(RSP_THRESHOLD_MASK | RSP_DRY | RSP_SYNCH)
+
+/* data2 THRESHOLD code of each Threshold value */
+static const u32 ThresholdCode[4] = {
+	RSP_THRESHOLD_166V,		/* Threshold_166V */
+	RSP_THRESHOLD_84V,		/* Threshold_84V */
+	RSP_THRESHOLD_33V,		/* Threshold_33V */
+	RSP_THRESHOLD_17V,		/* Threshold_17V */
+};
+
+static const char *const ClassName[REF_CLASSES] = {
+	"header", "frame", "command", "12v", "coil",
+	"threshold", "drywet", "sync", "relays", "timeout",
+};
+
+/* data2 field that differs, for each REF_ bit checked in data2 */
+static const struct {
+	u32 Mask;
+	u32 Class;
+} Data2Field[] = {
+	{ RSP_FRAME_ERROR,		REF_FRAME_ERROR },
+	{ RSP_COMMAND_ERROR_BIT,	REF_COMMAND_ERROR },
+	{ RSP_12V_RLY_OFF,		REF_12V },
+	{ RSP_COIL_ERROR,		REF_COIL_ERROR },
+	{ RSP_THRESHOLD_MASK,	REF_THRESHOLD },
+	{ RSP_DRY,				REF_DRY_WET },
+	{ RSP_SYNCH,			REF_SYNC },
+};
+
+static void PowerOn(RefBoard *B)
+{
+	B->Known = 1;
+	B->Threshold = Threshold_166V;
+	B->DryWet = Wet;
+	B->Synchronization = NoSynch;
+	B->Relays = 0;
+}
+
+void RefModel_Init(RefModel *M)
+{
+	u32 k;
+
+	for (k = 0; k < REF_POSITIONS; k++) {
+		M->Board[k].Known = 0;
+	}
+	M->Reset = RESET_RELEASE;
+}
+
+/*
+ * Follow the reset output. While it is asserted every position reads back
+ * its power-on state.
+ */
+void RefModel_SetReset(RefModel *M, u32 Reset)
+{
+	u32 k;
+
+	M->Reset = Reset;
+	if (Reset == RESET_ASSERT) {
+		for (k = 0; k < REF_POSITIONS; k++) {
+			PowerOn(&M->Board[k]);
+		}
+	}
+}
+
+/* The latched state the response to Command reflects */
+static RefBoard Latched(const RefModel *M, const u32 *Command)
+{
+	RefBoard B = M->Board[(Command[0] >> POS_Pos) & 0x7];
+	u32 Command2 = Command[1];
+
+	if (M->Reset == RESET_RELEASE && ((Command2 >> POS_CommandType) & 0x3) == ChangeRequest) {
+		B.Known = 1;
+		B.Threshold = (u8)((Command2 >> POS_Threshold) & 0x3);
+		B.DryWet = (u8)((Command2 >> POS_DryWet) & 0x1);
+		B.Synchronization = (u8)((Command2 >> POS_Synch) & 0x1);
+		B.Relays = (u8)(Command[2] & RSP_RELAY_MASK);
+	}
+	return B;
+}
+
+/****************************************************************************/
+/**
+*
+* Predict the response to a well-formed COMMAND frame.
+*
+* @param	M is the model state.
+* @param	Command is the COMMAND frame.
+* @param	Expected receives the RSP_WORDS expected response words.
+* @param	Care receives, per word, the bits that are predicted.
+*
+* @return	None.
+*
+*****************************************************************************/
+void RefModel_Expect(const RefModel *M, const u32 *Command, u32 *Expected, u32 *Care)
+{
+	RefBoard B = Latched(M, Command);
+	int i;
+
+	for (i = 0; i < RSP_WORDS; i++) {
+		Expected[i] = 0;
+		Care[i] = 0;
+	}
+
+	Expected[0] = Command[0] & 0xFFFF;
+	Care[0] = 0xFFFF;
+
+	Expected[1] = M->Reset == RESET_ASSERT ? RSP_12V_RLY_OFF : 0;
+	Care[1] = REF_DATA2_CARE;
+	if (B.Known) {
+		Expected[1] |= ThresholdCode[B.Threshold & 0x3];
+		if (B.DryWet == Dry) Expected[1] |= RSP_DRY;
+		if (B.Synchronization == Synch) Expected[1] |= RSP_SYNCH;
+		Care[1] |= REF_LATCHED_CARE;
+
+		if (((Command[1] >> POS_CommandType) & 0x3) != CPLDRev) {
+			Expected[2] = B.Relays;
+			Care[2] = RSP_RELAY_MASK;
+		}
+	}
+}
+
+/****************************************************************************/
+/**
+*
+* Compare the response to Command with the prediction and advance the model.
+* A ChangeRequest is latched only if the response shows the CPLD accepted it
+* (no FRAME or COMMAND ERROR), so one bad frame is reported once and does not
+* make every later frame differ.
+*
+* @param	M is the model state.
+* @param	Command is the COMMAND frame that was sent.
+* @param	Response is the RSP_WORDS response read back.
+*
+* @return	REF_HEADER..REF_RELAYS bits of the fields that differ, 0 if the
+*		response matches.
+*
+*****************************************************************************/
+u32 RefModel_Check(RefModel *M, const u32 *Command, const u32 *Response)
+{
+	u32 Expected[RSP_WORDS];
+	u32 Care[RSP_WORDS];
+	u32 Diff;
+	u32 Result = 0;
+	u32 i;
+
+	RefModel_Expect(M, Command, Expected, Care);
+
+	if ((Response[0] ^ Expected[0]) & Care[0]) {
+		Result |= REF_HEADER;
+	}
+	Diff = (Response[1] ^ Expected[1]) & Care[1];
+	if (Diff) {
+		for (i = 0; i < sizeof(Data2Field) / sizeof(Data2Field[0]); i++) {
+			if (Diff & Data2Field[i].Mask) {
+				Result |= Data2Field[i].Class;
+			}
+		}
+	}
+	if ((Response[2] ^ Expected[2]) & Care[2]) {
+		Result |= REF_RELAYS;
+	}
+
+	if (!(Response[1] & (RSP_FRAME_ERROR | RSP_COMMAND_ERROR_BIT))) {
+		M->Board[(Command[0] >> POS_Pos) & 0x7] = Latched(M, Command);
+	}
+	return Result;
+}
+
+/*
+ * No response to Command: whether the CPLD latched it is unknown, so a
+ * ChangeRequest leaves its position unchecked until the next one.
+ */
+u32 RefModel_Lost(RefModel *M, const u32 *Command)
+{
+	if (((Command[1] >> POS_CommandType) & 0x3) == ChangeRequest) {
+		M->Board[(Command[0] >> POS_Pos) & 0x7].Known = 0;
+	}
+	return REF_TIMEOUT;
+}
+
+/*
+ * Short name of REF_ bit number Class, for counters and dumps.
+ */
+const char *RefModel_ClassName(u32 Class)
+{
+	return Class < REF_CLASSES ? ClassName[Class] : "?";
+}
@@ -0,0 +1,62 @@
+/******************************************************************************
+* ref_model.h: reference model of the CPLD response
+*
+* Keeps the state each fixture position latches (threshold, dry/wet,
+* synchronization, relays) and predicts the response to a COMMAND frame:
+*
+*   data1   HEADER echoed
+*   data2   no FRAME or COMMAND ERROR for a well-formed frame, 12V_RLY OFF
+*           while reset is asserted, no COIL ERROR, THRESHOLD/DRY-WET/
+*           SYNCHRONIZE as latched by the last ChangeRequest
+*   data3   the latched relays (not for a CPLD revision read)
+*
+* The other bits and words are not checked. RefModel_Check() compares a
+* response field by field and returns which fields differ, then latches a
+* ChangeRequest the CPLD accepted. Reset clears the latched state to its
+* power-on values; until a position has seen a ChangeRequest its latched
+* fields are unknown and not checked.
+*
+* The model has no hardware dependencies and builds unchanged on the board
+* and the host.
+******************************************************************************/
+#ifndef REF_MODEL_H
+#define REF_MODEL_H
+
+#include "fixture.h"
+
+#define REF_POSITIONS		8		/* Command1 POS values */
+
+/* RefModel_Check() result, one bit per field that differs */
+#define REF_HEADER			0x001	/* data1 */
+#define REF_FRAME_ERROR		0x002
+#define REF_COMMAND_ERROR	0x004
+#define REF_12V				0x008
+#define REF_COIL_ERROR		0x010
+#define REF_THRESHOLD		0x020
+#define REF_DRY_WET			0x040
+#define REF_SYNC			0x080
+#define REF_RELAYS			0x100	/* data3 */
+#define REF_TIMEOUT			0x200	/* No response at all, see RefModel_Lost() */
+#define REF_CLASSES			10
+
+typedef struct {
+	u8 Known;				/* A ChangeRequest or reset has set the fields */
+	u8 Threshold;
+	u8 DryWet;
+	u8 Synchronization;
+	u8 Relays;
+} RefBoard;
+
+typedef struct {
+	RefBoard Board[REF_POSITIONS];
+	u32 Reset;				/* Level driven on the OUTPUT GPIO */
+} RefModel;
+
+void RefModel_Init(RefModel *M);
+void RefModel_SetReset(RefModel *M, u32 Reset);
+void RefModel_Expect(const RefModel *M, const u32 *Command, u32 *Expected, u32 *Care);
+u32 RefModel_Check(RefModel *M, const u32 *Command, const u32 *Response);
+u32 RefModel_Lost(RefModel *M, const u32 *Command);
+const char *RefModel_ClassName(u32 Class);
+
+#endif
@@ -0,0 +1,268 @@
+/******************************************************************************
+* relay_seq.c: timed relay sequences for coil endurance and contact timing
+******************************************************************************/
+#include <string.h>
+#include "relay_seq.h"
+#include "bram_cmd.h"
+#include "fmt.h"
+#include "timebase.h"
+
+#define RELAY_SEQ_LINE_MAX		80
+
+typedef struct {
+	const char *Name;
+	const RelaySeqStep *Steps;
+	u32 Count;
+} RelaySeqTable;
+
+/* All relays on and off, 5 ms each: one coil cycle per 10 ms */
+static const RelaySeqStep Endurance[] = {
+	{ RELAY_ALL, 5000 },
+	{ 0,		 5000 },
+};
+
+/* One relay at a time, so a readback bit that follows the wrong coil shows */
+static const RelaySeqStep Walk[] = {
+	{ RELAY_AA, 2000 }, { 0, 2000 },
+	{ RELAY_AB, 2000 }, { 0, 2000 },
+	{ RELAY_CA, 2000 }, { 0, 2000 },
+	{ RELAY_CB, 2000 }, { 0, 2000 },
+	{ RELAY_CC, 2000 }, { 0, 2000 },
+};
+
+static RelaySeqStep User[RELAY_SEQ_MAX_STEPS];
+static u32 UserCount;
+
+static const RelaySeqTable Tables[] = {
+	{ "endurance",	Endurance,	sizeof(Endurance) / sizeof(Endurance[0]) },
+	{ "walk",		Walk,		sizeof(Walk) / sizeof(Walk[0]) },
+	{ "user",		User,		0 },
+};
+
+static const RelaySeqTable *Selected = &Tables[0];
+
+/* The selected table compiled for one run */
+static u32 Frames[RELAY_SEQ_MAX_STEPS][CMD_WORDS];
+static u64 DwellTicks[RELAY_SEQ_MAX_STEPS];
+
+static RelaySeqResult Results[FIXTURE_RELAY_SEQ_RESULTS];
+static RelaySeqSummary Summary;
+static FmtBuf Out;
+
+static u32 StepCount(const RelaySeqTable *T)
+{
+	return T->Steps == User ? UserCount : T->Count;
+}
+
+/*
+ * Select the built-in table Name, or "user".
+ */
+int RelaySeq_Select(const char *Name)
+{
+	u32 i;
+
+	for (i = 0; i < sizeof(Tables) / sizeof(Tables[0]); i++) {
+		if (strcmp(Name, Tables[i].Name) == 0) {
+			Selected = &Tables[i];
+			return XST_SUCCESS;
+		}
+	}
+	return XST_FAILURE;
+}
+
+/*
+ * Append a step to the "user" table.
+ */
+int RelaySeq_Add(u8 Relays, u32 DwellUs)
+{
+	if (UserCount == RELAY_SEQ_MAX_STEPS || (Relays & ~RELAY_ALL)) {
+		return XST_FAILURE;
+	}
+	User[UserCount].Relays = Relays;
+	User[UserCount].DwellUs = DwellUs;
+	UserCount++;
+	return XST_SUCCESS;
+}
+
+void RelaySeq_Clear(void)
+{
+	UserCount = 0;
+}
+
+/* Build the COMMAND frame and dwell of every step of T */
+static void Compile(const RelaySeqTable *T, const FixtureConfig *Config, u8 SHnum)
+{
+	FixtureConfig Step = *Config;
+	u32 k;
+
+	Step.CommandType = ChangeRequest;
+	for (k = 0; k < StepCount(T); k++) {
+		Step.Relays = T->Steps[k].Relays;
+		BramCmd_BuildFrame(&Step, SHnum, Frames[k]);
+		DwellTicks[k] = Time_UsToTicks(T->Steps[k].DwellUs);
+	}
+}
+
+/****************************************************************************/
+/**
+*
+* Run the selected table Repeat times with one handshake per step, each
+* step's frame written at its deadline, and keep every response in the
+* result buffer. BRAM0 is left in single-frame mode with the relays of
+* Config commanded again.
+*
+* @param	Config is the commanded state the steps change the relays of.
+* @param	SHnum is the Sample and Hold number of every frame.
+* @param	Repeat is the number of passes through the table.
+*
+* @return	XST_SUCCESS, or XST_FAILURE if the table is empty or the run
+*		would not fit in FIXTURE_RELAY_SEQ_RESULTS.
+*
+*****************************************************************************/
+int RelaySeq_Run(const FixtureConfig *Config, u8 SHnum, u32 Repeat)
+{
+	u32 Count = StepCount(Selected);
+	u32 Response[RSP_WORDS];
+	u32 Restore[CMD_WORDS];
+	FixtureConfig Last = *Config;
+	RelaySeqResult *R;
+	u64 Deadline;
+	u64 Start;
+	u64 Now;
+	u32 Turnaround;
+	u32 LateUs;
+	u32 k;
+
+	memset(&Summary, 0, sizeof(Summary));
+	if (Count == 0 || Repeat == 0 || (u64)Count * Repeat > FIXTURE_RELAY_SEQ_RESULTS) {
+		return XST_FAILURE;
+	}
+	Compile(Selected, Config, SHnum);
+	BramCmd_SetMode(BRAM_MODE_SINGLE);
+
+	Start = Time_Now();
+	Deadline = Start;
+	R = Results;
+	while (Repeat--) {
+		for (k = 0; k < Count; k++, R++) {
+			Time_WaitUntil(Deadline);
+			Now = Time_Now();
+			BramCmd_WriteFrame(Frames[k]);
+
+			R->AtUs = (u32)Time_TicksToUs(Now - Start);
+			R->Commanded = Selected->Steps[k].Relays;
+			R->Flags = 0;
+			LateUs = (u32)Time_TicksToUs(Now - Deadline);
+			if (LateUs > Summary.MaxLateUs) Summary.MaxLateUs = LateUs;
+			if (LateUs > RELAY_SEQ_LATE_US) {
+				R->Flags |= RELAY_SEQ_LATE;
+				Summary.Late++;
+			}
+
+			if (BramCmd_WaitHandshake(HS_READ_EN,
+					Now + Time_UsToTicks(FIXTURE_READEN_TIMEOUT_US)) == XST_SUCCESS) {
+				Turnaround = (u32)Time_TicksToUs(Time_Now() - Now);
+				BramCmd_ReadFrame(Response);
+				R->Readback = (u8)(Response[2] & RSP_RELAY_MASK);
+				if (Response[1] & RSP_COIL_ERROR) {
+					R->Flags |= RELAY_SEQ_COIL_ERROR;
+					Summary.CoilErrors++;
+				}
+				if (R->Readback != R->Commanded) {
+					R->Flags |= RELAY_SEQ_MISMATCH;
+					Summary.Mismatches++;
+				}
+			}
+			else {
+				Turnaround = FIXTURE_READEN_TIMEOUT_US;
+				R->Readback = 0;
+				R->Flags |= RELAY_SEQ_TIMEOUT;
+				Summary.Timeouts++;
+			}
+			R->TurnaroundUs = (u16)(Turnaround > 0xFFFF ? 0xFFFF : Turnaround);
+			if (Turnaround > Summary.MaxTurnaroundUs) Summary.MaxTurnaroundUs = Turnaround;
+
+			Deadline += DwellTicks[k];
+		}
+	}
+	Time_WaitUntil(Deadline);
+	Summary.ElapsedUs = (u32)Time_TicksToUs(Time_Now() - Start);
+	Summary.Steps = (u32)(R - Results);
+
+	/* Back to the commanded relays */
+	Last.CommandType = ChangeRequest;
+	BramCmd_BuildFrame(&Last, SHnum, Restore);
+	BramCmd_WriteFrame(Restore);
+	BramCmd_WaitHandshake(HS_READ_EN, Time_Now() + Time_UsToTicks(FIXTURE_READEN_TIMEOUT_US));
+
+	return XST_SUCCESS;
+}
+
+const RelaySeqSummary *RelaySeq_Summary(void)
+{
+	return &Summary;
+}
+
+const RelaySeqResult *RelaySeq_Results(void)
+{
+	return Results;
+}
+
+void RelaySeq_PrintSummary(void)
+{
+	Fmt_Lit(&Out, "RELAY SEQUENCE ");
+	Fmt_Str(&Out, Selected->Name);
+	Fmt_Lit(&Out, ": ");
+	Fmt_Dec(&Out, Summary.Steps);
+	Fmt_Lit(&Out, " steps in ");
+	Fmt_Dec(&Out, Summary.ElapsedUs);
+	Fmt_Lit(&Out, " us\r\n  mismatches ");
+	Fmt_Dec(&Out, Summary.Mismatches);
+	Fmt_Lit(&Out, ", coil errors ");
+	Fmt_Dec(&Out, Summary.CoilErrors);
+	Fmt_Lit(&Out, ", timeouts ");
+	Fmt_Dec(&Out, Summary.Timeouts);
+	Fmt_Lit(&Out, "\r\n  late steps ");
+	Fmt_Dec(&Out, Summary.Late);
+	Fmt_Lit(&Out, " (max ");
+	Fmt_Dec(&Out, Summary.MaxLateUs);
+	Fmt_Lit(&Out, " us), max turnaround ");
+	Fmt_Dec(&Out, Summary.MaxTurnaroundUs);
+	Fmt_Lit(&Out, " us\r\n");
+	Fmt_Flush(&Out);
+}
+
+/*
+ * Print the first Count results of the last run (0 for all), one line each.
+ */
+void RelaySeq_Dump(u32 Count)
+{
+	const RelaySeqResult *R;
+	u32 n;
+
+	if (Count == 0 || Count > Summary.Steps) {
+		Count = Summary.Steps;
+	}
+	for (n = 0; n < Count; n++) {
+		R = &Results[n];
+		Fmt_Dec(&Out, n);
+		Fmt_Lit(&Out, " at ");
+		Fmt_Dec(&Out, R->AtUs);
+		Fmt_Lit(&Out, " us relays 0x");
+		Fmt_Hex4(&Out, R->Commanded);
+		Fmt_Lit(&Out, " read 0x");
+		Fmt_Hex4(&Out, R->Readback);
+		Fmt_Lit(&Out, " ta ");
+		Fmt_Dec(&Out, R->TurnaroundUs);
+		Fmt_Lit(&Out, " us");
+		if (R->Flags & RELAY_SEQ_MISMATCH) Fmt_Lit(&Out, " MISMATCH");
+		if (R->Flags & RELAY_SEQ_COIL_ERROR) Fmt_Lit(&Out, " COIL");
+		if (R->Flags & RELAY_SEQ_TIMEOUT) Fmt_Lit(&Out, " TIMEOUT");
+		if (R->Flags & RELAY_SEQ_LATE) Fmt_Lit(&Out, " LATE");
+		Fmt_Lit(&Out, "\r\n");
+		if (Out.Len > FMT_BUF_SIZE - RELAY_SEQ_LINE_MAX) {
+			Fmt_Flush(&Out);
+		}
+	}
+	Fmt_Flush(&Out);
+}
@@ -0,0 +1,67 @@
+/******************************************************************************
+* relay_seq.h: timed relay sequences for coil endurance and contact timing
+*
+* A sequence is a table of relay steps, each a RELAY_AA..RELAY_CC bitmask
+* and a dwell in microseconds until the next step. RelaySeq_Run() first
+* compiles the table into ChangeRequest COMMAND frames and global timer
+* deadlines, then runs it Repeat times: every step's frame is written at its
+* deadline (sleeping in WFI on the global timer comparator in between), and
+* its response is kept in a preallocated result buffer: data3 relay readback,
+* COIL ERROR, turnaround and how late the step started.
+*
+* Built-in tables are selected by name; "user" is the table built with
+* RelaySeq_Add().
+******************************************************************************/
+#ifndef RELAY_SEQ_H
+#define RELAY_SEQ_H
+
+#include "fixture.h"
+
+#define RELAY_SEQ_MAX_STEPS		64
+
+#ifndef FIXTURE_RELAY_SEQ_RESULTS
+#define FIXTURE_RELAY_SEQ_RESULTS	16384	/* Steps kept per run */
+#endif
+
+#define RELAY_SEQ_LATE_US		10		/* A step starting later than this is counted */
+
+/* RelaySeqResult.Flags */
+#define RELAY_SEQ_COIL_ERROR	0x01
+#define RELAY_SEQ_TIMEOUT		0x02
+#define RELAY_SEQ_MISMATCH		0x04	/* Readback is not the commanded mask */
+#define RELAY_SEQ_LATE			0x08
+
+typedef struct {
+	u8 Relays;				/* RELAY_AA..RELAY_CC bitmask */
+	u32 DwellUs;			/* Until the next step */
+} RelaySeqStep;
+
+typedef struct {
+	u32 AtUs;				/* Frame write, from the start of the run */
+	u16 TurnaroundUs;		/* Saturated at 0xFFFF */
+	u8 Commanded;
+	u8 Readback;			/* data3 & RSP_RELAY_MASK */
+	u8 Flags;
+} RelaySeqResult;
+
+typedef struct {
+	u32 Steps;				/* Results in the buffer */
+	u32 ElapsedUs;
+	u32 Mismatches;
+	u32 CoilErrors;
+	u32 Timeouts;
+	u32 Late;
+	u32 MaxLateUs;
+	u32 MaxTurnaroundUs;
+} RelaySeqSummary;
+
+int RelaySeq_Select(const char *Name);
+int RelaySeq_Add(u8 Relays, u32 DwellUs);
+void RelaySeq_Clear(void);
+int RelaySeq_Run(const FixtureConfig *Config, u8 SHnum, u32 Repeat);
+const RelaySeqSummary *RelaySeq_Summary(void);
+const RelaySeqResult *RelaySeq_Results(void);
+void RelaySeq_PrintSummary(void);
+void RelaySeq_Dump(u32 Count);
+
+#endif
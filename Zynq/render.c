@@ -0,0 +1,152 @@
+/******************************************************************************
+* render.c: delta-only terminal view of the decoded fixture status
+******************************************************************************/
+#include "render.h"
+#include "fmt.h"
+
+#define LINE_RESET			0
+#define LINE_COMMAND		1
+#define LINE_REV1			2
+#define LINE_REV2			3
+#define LINE_STATUS			4		/* First Render_Status[] entry */
+#define RENDER_LINES		(LINE_STATUS + RENDER_STATUS_LINES)
+
+#define PARK_ROW			29
+
+/* The relay and input texts keep the base application's trailing space */
+const RenderLine Render_Status[RENDER_STATUS_LINES] = {
+	{  7, 1, RENDER_FLAG, RSP_FRAME_ERROR,		{ FMT_TEXT("FRAME ERROR = 0 (GOOD)"), FMT_TEXT("FRAME ERROR = 1 (BAD)") } },
+	{  8, 1, RENDER_FLAG, RSP_COMMAND_ERROR,	{ FMT_TEXT("COMMAND ERROR = 0 (GOOD)"), FMT_TEXT("COMMAND ERROR = 1 (BAD)") } },
+	{  9, 1, RENDER_FLAG, RSP_12V_RLY_OFF,		{ FMT_TEXT("12V_RLY COMMAND = 0 (ON)"), FMT_TEXT("12V_RLY COMMAND = 1 (OFF)") } },
+	{ 10, 1, RENDER_FLAG, RSP_COIL_ERROR,		{ FMT_TEXT("COIL ERROR = 0 (GOOD)"), FMT_TEXT("COIL ERROR = 1 (BAD)") } },
+	{ 11, 1, 10, RSP_THRESHOLD_MASK,			{ FMT_TEXT("THRESHOLD = 166V"), FMT_TEXT("THRESHOLD = 33V"),
+												  FMT_TEXT("THRESHOLD = 84V"), FMT_TEXT("THRESHOLD = 17V") } },
+	{ 12, 1, RENDER_FLAG, RSP_DRY,				{ FMT_TEXT("DRY/WET = 0 (WET Used)"), FMT_TEXT("DRY/WET = 1 (DRY Used)") } },
+	{ 13, 1, RENDER_FLAG, RSP_SYNCH,			{ FMT_TEXT("SYNCHRONIZE = 0"), FMT_TEXT("SYNCHRONIZE = 1") } },
+	{ 15, 2, RENDER_FLAG, RELAY_AA,				{ FMT_TEXT("RelayAA = OFF "), FMT_TEXT("RelayAA = ON ") } },
+	{ 16, 2, RENDER_FLAG, RELAY_AB,				{ FMT_TEXT("RelayAB = OFF "), FMT_TEXT("RelayAB = ON ") } },
+	{ 17, 2, RENDER_FLAG, RELAY_CA,				{ FMT_TEXT("RelayCA = OFF "), FMT_TEXT("RelayCA = ON ") } },
+	{ 18, 2, RENDER_FLAG, RELAY_CB,				{ FMT_TEXT("RelayCB = OFF "), FMT_TEXT("RelayCB = ON ") } },
+	{ 19, 2, RENDER_FLAG, RELAY_CC,				{ FMT_TEXT("RelayCC = OFF "), FMT_TEXT("RelayCC = ON ") } },
+	{ 21, 3, RENDER_FLAG, 0x01,					{ FMT_TEXT("Input_1 = OFF "), FMT_TEXT("Input_1 = ON ") } },
+	{ 22, 3, RENDER_FLAG, 0x02,					{ FMT_TEXT("Input_2 = OFF "), FMT_TEXT("Input_2 = ON ") } },
+	{ 23, 3, RENDER_FLAG, 0x04,					{ FMT_TEXT("Input_3 = OFF "), FMT_TEXT("Input_3 = ON ") } },
+	{ 24, 3, RENDER_FLAG, 0x08,					{ FMT_TEXT("Input_4 = OFF "), FMT_TEXT("Input_4 = ON ") } },
+	{ 25, 3, RENDER_FLAG, 0x10,					{ FMT_TEXT("Input_5 = OFF "), FMT_TEXT("Input_5 = ON ") } },
+	{ 26, 3, RENDER_FLAG, 0x20,					{ FMT_TEXT("Input_6 = OFF "), FMT_TEXT("Input_6 = ON ") } },
+	{ 27, 3, RENDER_FLAG, 0x40,					{ FMT_TEXT("Input_7 = OFF "), FMT_TEXT("Input_7 = ON ") } },
+};
+
+u32 Render_Value(const RenderLine *Line, const u32 *Data)
+{
+	u32 Value = Data[Line->Word] & Line->Mask;
+
+	return Line->Shift == RENDER_FLAG ? (Value != 0) : Value >> Line->Shift;
+}
+
+static u32 Last[RENDER_LINES];
+static int Valid;
+
+void Render_Invalidate(void)
+{
+	Valid = 0;
+}
+
+static void Decode(const Fixture *F, u32 *Line)
+{
+	u32 i;
+
+	Line[LINE_RESET] = F->Reset;
+	Line[LINE_COMMAND] = F->Config.CommandType;
+	Line[LINE_REV1] = F->CpldRev1;
+	Line[LINE_REV2] = F->CpldRev2;
+	for (i = 0; i < RENDER_STATUS_LINES; i++) {
+		Line[LINE_STATUS + i] = Render_Value(&Render_Status[i], F->Data);
+	}
+}
+
+/* ESC [ Row ;1H */
+static void MoveTo(u32 Row)
+{
+	Fmt_Lit(&Fmt_View, "\x1b[");
+	Fmt_Dec(&Fmt_View, Row);
+	Fmt_Lit(&Fmt_View, ";1H");
+}
+
+static void Draw(u32 Index, u32 Value)
+{
+	const RenderLine *Status;
+
+	switch (Index) {
+	case LINE_RESET:
+		MoveTo(1);
+		if (Value) {
+			Fmt_Lit(&Fmt_View, "FIXTURE IN OPERATION");
+		}
+		else Fmt_Lit(&Fmt_View, "FIXTURE IN RESET");
+		break;
+	case LINE_COMMAND:
+		MoveTo(3);
+		if (Value == DataUpdate) {
+			Fmt_Lit(&Fmt_View, "COMMAND = DATA UPDATE ONLY, can't operate relays");
+		}
+		else if (Value == ChangeRequest) {
+			Fmt_Lit(&Fmt_View, "COMMAND = CHANGE REQUEST");
+		}
+		else Fmt_Lit(&Fmt_View, "COMMAND = CPLD REVISION");
+		break;
+	case LINE_REV1:
+		MoveTo(5);
+		Fmt_Lit(&Fmt_View, "CPLD_REV MM-DD = 0x");
+		Fmt_Hex4(&Fmt_View, Value);
+		break;
+	case LINE_REV2:
+		MoveTo(6);
+		Fmt_Lit(&Fmt_View, "CPLD_REV YY-RR = 0x");
+		Fmt_Hex4(&Fmt_View, Value);
+		break;
+	default:
+		Status = &Render_Status[Index - LINE_STATUS];
+		MoveTo(Status->Row);
+		Fmt_Text(&Fmt_View, &Status->Text[Value & 0x3]);
+		break;
+	}
+	Fmt_Lit(&Fmt_View, "\x1b[K");
+}
+
+/****************************************************************************/
+/**
+*
+* Bring the terminal up to date with the status decoded from F.
+*
+* @param	F is the fixture state after Fixture_Cycle().
+*
+* @return	Number of status lines rewritten, 0 if nothing was sent.
+*
+*****************************************************************************/
+u32 Render_Delta(const Fixture *F)
+{
+	u32 Line[RENDER_LINES];
+	u32 Drawn = 0;
+	u32 i;
+
+	Decode(F, Line);
+
+	if (!Valid) {
+		Fmt_Lit(&Fmt_View, "\x1b[2J");
+	}
+	for (i = 0; i < RENDER_LINES; i++) {
+		if (!Valid || Line[i] != Last[i]) {
+			Draw(i, Line[i]);
+			Last[i] = Line[i];
+			Drawn++;
+		}
+	}
+	if (Drawn) {
+		MoveTo(PARK_ROW);
+		Fmt_Flush(&Fmt_View);
+	}
+	Valid = 1;
+
+	return Drawn;
+}
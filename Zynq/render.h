@@ -0,0 +1,41 @@
+/******************************************************************************
+* render.h: delta-only terminal view of the decoded fixture status
+*
+* Each decoded status line has a fixed row on the terminal. The renderer keeps
+* the value every line was last drawn with and, on each cycle, rewrites only
+* the rows whose value changed, using cursor-addressed escapes. When nothing
+* changed no bytes are sent at all. The raw command/response words change
+* every cycle (SHnum) and are left to the text and binary views.
+*
+* Render_Status[] holds the data2/data3/data4 status lines for both this view
+* and the text view of Fixture_Report(), so their labels live in one place.
+******************************************************************************/
+#ifndef RENDER_H
+#define RENDER_H
+
+#include "fixture.h"
+#include "fmt.h"
+
+/*
+ * One decoded status line, Text[Value] with Value = (Data[Word] & Mask) >>
+ * Shift, or (Data[Word] & Mask) != 0 for RENDER_FLAG. Row is its line in the
+ * delta view; the text view leaves a blank line where the rows skip one.
+ */
+#define RENDER_FLAG			0xFF
+#define RENDER_STATUS_LINES	19
+
+typedef struct {
+	u8 Row;
+	u8 Word;				/* Index into Fixture.Data, data2 = 1 */
+	u8 Shift;				/* RENDER_FLAG for a single bit */
+	u16 Mask;
+	FmtText Text[4];
+} RenderLine;
+
+extern const RenderLine Render_Status[RENDER_STATUS_LINES];
+
+u32 Render_Value(const RenderLine *Line, const u32 *Data);
+void Render_Invalidate(void);
+u32 Render_Delta(const Fixture *F);
+
+#endif
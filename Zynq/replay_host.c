@@ -0,0 +1,265 @@
+/******************************************************************************
+* replay_host.c: replay a recorded fixture session on Linux
+*
+* Reads a session recorded on the board in the record output mode (see
+* record.h; "out record", console UART captured to a file) and feeds every
+* frame back through Fixture_Replay() and Fixture_Report(): the same frame
+* book-keeping, trace ring, statistics and text/delta/trace/stats views as
+* the board, with the CPLD and BSP calls left to the host backends. The clock
+* is the recorded one (Time_Replay()), so the time-based views come out the
+* same on every run, while the frames are fed as fast as they decode.
+*
+*   gcc -std=c99 -O2 -DFIXTURE_HOST -DFIXTURE_REPLAY -o fixture_replay *.c
+*   ./fixture_replay [-m text|binary|delta|trace|stats|record] [-d N] [-q]
+*                    [-t tag] [-f json|text] FILE
+*
+* The views go to stdout (-q sends them to /dev/null), the result to stderr:
+* frames, skipped bytes, Seq gaps, timeouts, recorded time and the host CPU
+* time per frame (p50/p99/max), one JSON object per run like fixture_bench.
+* -d prints the newest N trace records with an error at the end.
+******************************************************************************/
+#if defined(FIXTURE_HOST) && defined(FIXTURE_REPLAY)
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "fixture.h"
+#include "bram_cmd.h"
+#include "record.h"
+#include "station.h"
+#include "trace.h"
+#include "stats.h"
+#include "timebase.h"
+#include "uart_cli.h"
+
+typedef struct {
+	u32 Frames;
+	u32 Skipped;			/* Bytes outside valid records */
+	u32 Gaps;				/* Seq discontinuities, records lost on the UART */
+	u32 Timeouts;
+	u64 RecordedUs;
+	u64 ElapsedNs;
+	u32 P50Ns;
+	u32 P99Ns;
+	u32 MaxNs;
+} ReplayResult;
+
+static const char *const Modes[] = { "text", "binary", "delta", "trace", "stats", "record", NULL };
+
+static Fixture Fix[STATION_MAX_FIXTURES];
+static u8 SeqValid[STATION_MAX_FIXTURES];
+static u32 *Latency;
+
+/* Host CPU time, independent of the replayed Time_Now() */
+static u64 HostNs(void)
+{
+	struct timespec Now;
+
+	clock_gettime(CLOCK_MONOTONIC, &Now);
+	return (u64)Now.tv_sec * 1000000000ull + (u64)Now.tv_nsec;
+}
+
+static int CompareU32(const void *a, const void *b)
+{
+	u32 x = *(const u32 *)a;
+	u32 y = *(const u32 *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static u8 *ReadFile(const char *Name, u32 *Len)
+{
+	FILE *In = fopen(Name, "rb");
+	u8 *Buf;
+	long Size;
+
+	if (In == NULL || fseek(In, 0, SEEK_END) != 0 || (Size = ftell(In)) < 0 ||
+			fseek(In, 0, SEEK_SET) != 0) {
+		if (In != NULL) fclose(In);
+		return NULL;
+	}
+	Buf = malloc((size_t)Size + 1);
+	if (Buf != NULL && fread(Buf, 1, (size_t)Size, In) != (size_t)Size) {
+		free(Buf);
+		Buf = NULL;
+	}
+	fclose(In);
+	*Len = (u32)Size;
+	return Buf;
+}
+
+/****************************************************************************/
+/**
+*
+* Replay every valid record of Buf in order, reporting each frame in Mode.
+*
+* @param	Buf holds the recorded session.
+* @param	Len is its length in bytes.
+* @param	Mode is the OUTPUT_* mode of the replayed fixtures.
+* @param	R receives the counts and timings.
+*
+* @return	None.
+*
+*****************************************************************************/
+static void Replay(const u8 *Buf, u32 Len, u32 Mode, ReplayResult *R)
+{
+	RecordFrame Rec;
+	Fixture *F;
+	u64 Clock = 0;
+	u64 Begin;
+	u64 Start;
+	u32 Pos;
+	u32 i = 0;
+
+	memset(R, 0, sizeof(*R));
+	for (Pos = 0; Pos < STATION_MAX_FIXTURES; Pos++) {
+		Fix[Pos].OutputMode = (u8)Mode;
+	}
+
+	Begin = HostNs();
+	while (i + RECORD_SIZE <= Len) {
+		if (Buf[i] != RECORD_SYNC0 || Record_Decode(Buf + i, &Rec) != XST_SUCCESS) {
+			R->Skipped++;
+			i++;
+			continue;
+		}
+		i += RECORD_SIZE;
+
+		Start = HostNs();
+		Clock += Time_UsToTicks(Rec.DeltaUs);
+		Time_Replay(Clock);
+		Pos = (Rec.Command[0] >> POS_Pos) & (STATION_MAX_FIXTURES - 1);
+		F = &Fix[Pos];
+		if (SeqValid[Pos] && Rec.Seq != (u16)F->Seq) {
+			R->Gaps++;
+		}
+		SeqValid[Pos] = 1;
+		F->Seq = Rec.Seq;
+		F->Reset = (Rec.Flags & RECORD_FLAG_RESET) ? RESET_RELEASE : RESET_ASSERT;
+		Fixture_Replay(F, Rec.Command, Rec.Data,
+				(Rec.Flags & RECORD_FLAG_TIMEOUT) ? XST_FAILURE : XST_SUCCESS, Rec.TurnaroundUs);
+		Fixture_Report(F);
+		Latency[R->Frames++] = (u32)(HostNs() - Start);
+	}
+	R->Skipped += Len - i;
+	R->ElapsedNs = HostNs() - Begin;
+	R->RecordedUs = Time_TicksToUs(Clock);
+	for (Pos = 0; Pos < STATION_MAX_FIXTURES; Pos++) {
+		R->Timeouts += Fix[Pos].Timeouts;
+	}
+
+	qsort(Latency, R->Frames, sizeof(Latency[0]), CompareU32);
+	R->P50Ns = R->Frames ? Latency[(R->Frames - 1) / 2] : 0;
+	R->P99Ns = R->Frames ? Latency[(u32)((u64)(R->Frames - 1) * 99 / 100)] : 0;
+	R->MaxNs = R->Frames ? Latency[R->Frames - 1] : 0;
+}
+
+static void PrintResult(const char *Name, u32 Mode, const ReplayResult *R,
+		const char *Tag, int Json)
+{
+	double Fps = R->ElapsedNs ? (double)R->Frames * 1e9 / (double)R->ElapsedNs : 0.0;
+
+	if (Json) {
+		fprintf(stderr, "{\"file\":\"%s\",\"mode\":\"%s\",", Name, Modes[Mode]);
+		if (Tag != NULL) {
+			fprintf(stderr, "\"tag\":\"%s\",", Tag);
+		}
+		fprintf(stderr, "\"frames\":%u,\"skipped\":%u,\"gaps\":%u,\"timeouts\":%u,"
+				"\"recorded_ms\":%u,\"fps\":%.1f,\"p50_ns\":%u,\"p99_ns\":%u,\"max_ns\":%u}\n",
+				R->Frames, R->Skipped, R->Gaps, R->Timeouts, (u32)(R->RecordedUs / 1000),
+				Fps, R->P50Ns, R->P99Ns, R->MaxNs);
+	}
+	else {
+		fprintf(stderr, "%s (%s): %u frames, %u bytes skipped, %u gaps, %u timeouts, "
+				"%u ms recorded\n%10.0f fps  p50 %8u ns  p99 %8u ns  max %9u ns\n",
+				Name, Modes[Mode], R->Frames, R->Skipped, R->Gaps, R->Timeouts,
+				(u32)(R->RecordedUs / 1000), Fps, R->P50Ns, R->P99Ns, R->MaxNs);
+	}
+}
+
+static int Usage(const char *Name)
+{
+	fprintf(stderr, "usage: %s [-m text|binary|delta|trace|stats|record] [-d N] [-q] "
+			"[-t tag] [-f json|text] FILE\n", Name);
+	return 1;
+}
+
+int main(int argc, char *argv[])
+{
+	const char *Tag = NULL;
+	u32 Mode = OUTPUT_TRACE;
+	u32 DumpCount = 0;
+	int Quiet = 0;
+	int Json = 1;
+	ReplayResult R;
+	u32 Len = 0;
+	u8 *Buf;
+	u32 Pos;
+	int Opt;
+
+	while ((Opt = getopt(argc, argv, "m:d:qt:f:")) != -1) {
+		switch (Opt) {
+		case 'm':
+			for (Mode = 0; Modes[Mode] != NULL && strcmp(Modes[Mode], optarg) != 0; Mode++);
+			if (Modes[Mode] == NULL) return Usage(argv[0]);
+			break;
+		case 'd':
+			DumpCount = (u32)strtoul(optarg, NULL, 0);
+			break;
+		case 'q':
+			Quiet = 1;
+			break;
+		case 't':
+			Tag = optarg;
+			break;
+		case 'f':
+			Json = strcmp(optarg, "text") != 0;
+			break;
+		default:
+			return Usage(argv[0]);
+		}
+	}
+	if (optind != argc - 1) {
+		return Usage(argv[0]);
+	}
+
+	Buf = ReadFile(argv[optind], &Len);
+	Latency = malloc((Len / RECORD_SIZE + 1) * sizeof(Latency[0]));
+	if (Buf == NULL || Latency == NULL) {
+		perror(argv[optind]);
+		return 1;
+	}
+	if (Quiet && freopen("/dev/null", "w", stdout) == NULL) {
+		perror("fixture_replay");
+		return 1;
+	}
+
+	UartCli_Init(UART_BAUD_RATE);
+	if (BramCmd_Init() != XST_SUCCESS) {
+		return 1;
+	}
+	for (Pos = 0; Pos < STATION_MAX_FIXTURES; Pos++) {
+		Fixture_Init(&Fix[Pos]);
+	}
+	Trace_Clear();
+
+	Replay(Buf, Len, Mode, &R);
+	if (Mode == OUTPUT_STATS) {
+		for (Pos = 0; Pos < STATION_MAX_FIXTURES; Pos++) {
+			if (SeqValid[Pos]) Stats_Print(&Fix[Pos]);
+		}
+	}
+	if (DumpCount != 0) {
+		Trace_Dump(TRACE_ANY_ERROR, DumpCount);
+	}
+	UartCli_Flush();
+	PrintResult(argv[optind], Mode, &R, Tag, Json);
+
+	free(Latency);
+	free(Buf);
+	return 0;
+}
+
+#endif /* FIXTURE_HOST && FIXTURE_REPLAY */
@@ -0,0 +1,223 @@
+/******************************************************************************
+* sched.c: fixed-period fixture cycle scheduler
+******************************************************************************/
+#ifdef FIXTURE_HOST
+#define _POSIX_C_SOURCE 200809L
+#include <time.h>
+#endif
+
+#include "sched.h"
+#include "intc.h"
+
+static u32 Period;
+static u32 Overruns;
+
+u32 Sched_Period(void)
+{
+	return Period;
+}
+
+/*
+ * Number of cycles that started late because the previous one overran its
+ * period, since start-up.
+ */
+u32 Sched_Overruns(void)
+{
+	return Overruns;
+}
+
+#ifndef FIXTURE_HOST
+#include "xparameters.h"
+#include "xscutimer.h"
+#include "xpseudo_asm.h"
+#include "xil_exception.h"
+
+#define TIMER_DEVICE_ID		XPAR_XSCUTIMER_0_DEVICE_ID
+#define TIMER_IRPT_INTR		XPAR_SCUTIMER_INTR
+#define TIMER_HZ			(XPAR_CPU_CORTEXA9_0_CPU_CLK_FREQ_HZ / 2)
+
+static XScuTimer Timer;
+static volatile u32 Ticks;
+static u32 LastTick;
+
+static void TimerIsr(void *CallBackRef)
+{
+	XScuTimer *TimerPtr = (XScuTimer *)CallBackRef;
+
+	XScuTimer_ClearInterruptStatus(TimerPtr);
+	Ticks++;
+}
+
+int Sched_Init(u32 PeriodUs)
+{
+	XScuTimer_Config *ConfigPtr;
+	int Status;
+
+	ConfigPtr = XScuTimer_LookupConfig(TIMER_DEVICE_ID);
+	if (ConfigPtr == NULL) {
+		return XST_FAILURE;
+	}
+	Status = XScuTimer_CfgInitialize(&Timer, ConfigPtr, ConfigPtr->BaseAddr);
+	if (Status != XST_SUCCESS) {
+		return XST_FAILURE;
+	}
+
+	Status = Intc_Init();
+	if (Status != XST_SUCCESS) {
+		return XST_FAILURE;
+	}
+	Status = Intc_Connect(TIMER_IRPT_INTR, TimerIsr, &Timer);
+	if (Status != XST_SUCCESS) {
+		return XST_FAILURE;
+	}
+
+	XScuTimer_EnableAutoReload(&Timer);
+	XScuTimer_EnableInterrupt(&Timer);
+
+	return Sched_SetPeriod(PeriodUs);
+}
+
+/****************************************************************************/
+/**
+*
+* Change the cycle period. The timer is reloaded, so the next cycle starts
+* one full period from now.
+*
+* @param	PeriodUs is the period in microseconds, 0 for back-to-back
+*		cycles. Non-zero values are raised to SCHED_MIN_PERIOD_US.
+*
+* @return	XST_SUCCESS, or XST_FAILURE if PeriodUs is over
+*		SCHED_MAX_PERIOD_US; the period is then left as it was.
+*
+*****************************************************************************/
+int Sched_SetPeriod(u32 PeriodUs)
+{
+	u64 Load;
+
+	if (PeriodUs > SCHED_MAX_PERIOD_US) {
+		return XST_FAILURE;
+	}
+	XScuTimer_Stop(&Timer);
+	Period = PeriodUs;
+	if (Period == 0) {
+		return XST_SUCCESS;
+	}
+	if (Period < SCHED_MIN_PERIOD_US) {
+		Period = SCHED_MIN_PERIOD_US;
+	}
+
+	Load = (u64)Period * TIMER_HZ / 1000000 - 1;
+	XScuTimer_LoadTimer(&Timer, (u32)Load);
+	LastTick = Ticks;
+	XScuTimer_Start(&Timer);
+
+	return XST_SUCCESS;
+}
+
+/****************************************************************************/
+/**
+*
+* Sleep in WFI until the next period boundary.
+*
+* @return	Number of boundaries that passed since the previous call,
+*		normally 1. More than 1 means the previous cycle overran.
+*
+*****************************************************************************/
+u32 Sched_WaitNextCycle(void)
+{
+	u32 Elapsed;
+
+	if (Period == 0) {
+		return 1;
+	}
+
+	/* IRQs masked from the test to WFI, so a tick in between still wakes it */
+	while (Ticks == LastTick) {
+		Xil_ExceptionDisable();
+		if (Ticks == LastTick) {
+			wfi();
+		}
+		Xil_ExceptionEnable();
+	}
+	Elapsed = Ticks - LastTick;
+	LastTick += Elapsed;
+	if (Elapsed > 1) {
+		Overruns += Elapsed - 1;
+	}
+	return Elapsed;
+}
+
+/*
+ * Sleep until any interrupt (UART receive, timer tick) arrives, unless Ready()
+ * already holds. Ready() is tested with IRQs masked, as in
+ * Sched_WaitNextCycle(), so an interrupt just before the WFI still wakes it.
+ */
+void Sched_Idle(int (*Ready)(void))
+{
+	Xil_ExceptionDisable();
+	if (!Ready()) {
+		wfi();
+	}
+	Xil_ExceptionEnable();
+}
+
+#else /* FIXTURE_HOST */
+
+#include "timebase.h"
+
+static u64 NextDue;			/* Time_Now() ticks, nanoseconds on the host */
+
+int Sched_Init(u32 PeriodUs)
+{
+	return Sched_SetPeriod(PeriodUs);
+}
+
+int Sched_SetPeriod(u32 PeriodUs)
+{
+	if (PeriodUs > SCHED_MAX_PERIOD_US) {
+		return XST_FAILURE;
+	}
+	Period = PeriodUs;
+	if (Period != 0 && Period < SCHED_MIN_PERIOD_US) {
+		Period = SCHED_MIN_PERIOD_US;
+	}
+	NextDue = Time_Now() + (u64)Period * 1000;
+	return XST_SUCCESS;
+}
+
+u32 Sched_WaitNextCycle(void)
+{
+	struct timespec Due;
+	u64 PeriodNs = (u64)Period * 1000;
+	u64 Now;
+	u32 Elapsed = 1;
+
+	if (Period == 0) {
+		return 1;
+	}
+
+	Now = Time_Now();
+	if (Now >= NextDue + PeriodNs) {
+		Elapsed = (u32)((Now - NextDue) / PeriodNs) + 1;
+		Overruns += Elapsed - 1;
+		NextDue += (u64)(Elapsed - 1) * PeriodNs;
+	}
+
+	Due.tv_sec = (time_t)(NextDue / 1000000000ull);
+	Due.tv_nsec = (long)(NextDue % 1000000000ull);
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &Due, NULL) != 0);
+	NextDue += PeriodNs;
+
+	return Elapsed;
+}
+
+void Sched_Idle(int (*Ready)(void))
+{
+	struct timespec Nap = { 0, 1000000 };
+
+	if (!Ready()) {
+		nanosleep(&Nap, NULL);
+	}
+}
+
+#endif
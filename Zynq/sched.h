@@ -0,0 +1,33 @@
+/******************************************************************************
+* sched.h: fixed-period fixture cycle scheduler
+*
+* On the board the Cortex-A9 private timer (XScuTimer) interrupts once per
+* period and the core sleeps in WFI until the next tick, so every fixture
+* cycle starts on the period boundary whatever the loop body costs. On the host
+* the same deadlines are met with clock_nanosleep(). A period of 0 runs cycles
+* back to back.
+******************************************************************************/
+#ifndef SCHED_H
+#define SCHED_H
+
+#include "fixture.h"
+
+#ifndef FIXTURE_CYCLE_PERIOD_US
+#ifdef FIXTURE_HOST
+#define FIXTURE_CYCLE_PERIOD_US	0
+#else
+#define FIXTURE_CYCLE_PERIOD_US	1000000		/* 1 s, the old BRAM_DELAY1 spin */
+#endif
+#endif
+
+#define SCHED_MIN_PERIOD_US		10
+#define SCHED_MAX_PERIOD_US		10000000	/* Private timer load stays within 32 bits */
+
+int Sched_Init(u32 PeriodUs);
+int Sched_SetPeriod(u32 PeriodUs);
+u32 Sched_Period(void);
+u32 Sched_WaitNextCycle(void);
+u32 Sched_Overruns(void);
+void Sched_Idle(int (*Ready)(void));
+
+#endif
@@ -0,0 +1,213 @@
+/******************************************************************************
+* soak.c: randomized long-run check of the CPLD against the reference model
+******************************************************************************/
+#include <string.h>
+#include "soak.h"
+#include "bram_cmd.h"
+#include "fmt.h"
+#include "uart_cli.h"
+#include "timebase.h"
+
+#define SOAK_LINE_MAX		160
+
+static FmtBuf Out;
+
+static u32 NextRandom(u32 *State)
+{
+	u32 x = *State;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*State = x;
+	return x;
+}
+
+/* A random, well-formed configuration at the position of Config */
+static void RandomConfig(FixtureConfig *C, u32 *Rng, u8 *SHnum)
+{
+	u32 r = NextRandom(Rng);
+
+	/* Mostly ChangeRequest, a DataUpdate in four, a revision read in sixteen */
+	C->CommandType = (r & 0xF) == 0 ? CPLDRev : (r & 0x3) == 1 ? DataUpdate : ChangeRequest;
+	C->Threshold = (r >> 4) & 0x3;
+	C->DryWet = (r >> 6) & 0x1;
+	C->Synchronization = (r >> 7) & 0x1;
+	C->Relays = ((r >> 8) & 0xFF) % (RELAY_ALL + 1);
+	*SHnum = (u8)(((r >> 16) & 0xFF) % (SHNUM_WRAP + 1));
+}
+
+static void FormatProgress(FmtBuf *B, const SoakResult *S)
+{
+	Fmt_Lit(B, "SOAK ");
+	Fmt_Dec(B, S->Cycles);
+	Fmt_Lit(B, " frames, ");
+	Fmt_Dec(B, S->Failed);
+	Fmt_Lit(B, " failed\r\n");
+}
+
+/****************************************************************************/
+/**
+*
+* Send Cycles random COMMAND frames at the position of Config, one handshake
+* each, and check every response against the reference model. BRAM0 is left
+* in single-frame mode, reset released and the relays and settings of Config
+* commanded again.
+*
+* @param	S receives the counters and the failing frames.
+* @param	Config gives the fixture position; its settings are restored.
+* @param	Cycles is the number of frames to send.
+* @param	Seed selects the random sequence, not 0.
+*
+* @return	XST_SUCCESS if every response matched, XST_FAILURE otherwise.
+*
+*****************************************************************************/
+int Soak_Run(SoakResult *S, const FixtureConfig *Config, u32 Cycles, u32 Seed)
+{
+	FixtureConfig C = *Config;
+	RefModel Model;
+	SoakFailure *Fail;
+	u32 Command[CMD_WORDS];
+	u32 Response[RSP_WORDS];
+	u32 Rng = Seed ? Seed : 1;
+	u32 Mismatch;
+	u32 Class;
+	u64 Start;
+	u64 NextProgress;
+	u64 Now;
+	u8 SHnum;
+	u8 Key;
+
+	memset(S, 0, sizeof(*S));
+	S->Seed = Rng;
+	RefModel_Init(&Model);
+	BramCmd_SetMode(BRAM_MODE_SINGLE);
+	BramCmd_WriteReset(RESET_RELEASE);
+
+	Start = Time_Now();
+	NextProgress = Start + Time_UsToTicks(SOAK_PROGRESS_MS * 1000);
+	while (S->Cycles < Cycles) {
+		if (NextRandom(&Rng) % SOAK_RESET_ODDS == 0) {
+			RefModel_SetReset(&Model, Model.Reset == RESET_ASSERT ? RESET_RELEASE : RESET_ASSERT);
+			BramCmd_WriteReset(Model.Reset);
+		}
+		RandomConfig(&C, &Rng, &SHnum);
+		BramCmd_BuildFrame(&C, SHnum, Command);
+
+		BramCmd_WriteFrame(Command);
+		if (BramCmd_WaitHandshake(HS_READ_EN,
+				Time_Now() + Time_UsToTicks(FIXTURE_READEN_TIMEOUT_US)) == XST_SUCCESS) {
+			BramCmd_ReadFrame(Response);
+			Mismatch = RefModel_Check(&Model, Command, Response);
+		}
+		else {
+			memset(Response, 0, sizeof(Response));
+			Mismatch = RefModel_Lost(&Model, Command);
+			S->Lost++;
+		}
+		S->Cycles++;
+
+		if (Mismatch) {
+			S->Failed++;
+			for (Class = 0; Class < REF_CLASSES; Class++) {
+				if (Mismatch & (1u << Class)) S->Count[Class]++;
+			}
+			if (S->Kept < SOAK_MAX_FAILURES) {
+				Fail = &S->Failure[S->Kept++];
+				Fail->Cycle = S->Cycles - 1;
+				Fail->Mismatch = Mismatch;
+				memcpy(Fail->Command, Command, sizeof(Command));
+				memcpy(Fail->Response, Response, sizeof(Response));
+			}
+		}
+
+		if ((S->Cycles & 0xFF) == 0) {
+			Now = Time_Now();
+			if (Now >= NextProgress) {
+				FormatProgress(&Out, S);
+				Fmt_Flush(&Out);
+				NextProgress = Now + Time_UsToTicks(SOAK_PROGRESS_MS * 1000);
+			}
+			if (UartCli_TryRecvByte(&Key)) {
+				break;
+			}
+		}
+	}
+	S->ElapsedUs = (u32)Time_TicksToUs(Time_Now() - Start);
+
+	/* Back to the fixture's own state */
+	BramCmd_WriteReset(RESET_RELEASE);
+	C = *Config;
+	C.CommandType = ChangeRequest;
+	BramCmd_BuildFrame(&C, 0, Command);
+	BramCmd_WriteFrame(Command);
+	BramCmd_WaitHandshake(HS_READ_EN, Time_Now() + Time_UsToTicks(FIXTURE_READEN_TIMEOUT_US));
+
+	return S->Failed ? XST_FAILURE : XST_SUCCESS;
+}
+
+void Soak_PrintSummary(const SoakResult *S)
+{
+	u32 Class;
+
+	Fmt_Lit(&Out, "SOAK seed ");
+	Fmt_Dec(&Out, S->Seed);
+	Fmt_Lit(&Out, ": ");
+	Fmt_Dec(&Out, S->Cycles);
+	Fmt_Lit(&Out, " frames in ");
+	Fmt_Dec(&Out, S->ElapsedUs / 1000);
+	Fmt_Lit(&Out, " ms, ");
+	Fmt_Dec(&Out, S->Failed);
+	Fmt_Lit(&Out, " failed (");
+	Fmt_Dec(&Out, S->Kept);
+	Fmt_Lit(&Out, " kept)\r\n ");
+	for (Class = 0; Class < REF_CLASSES; Class++) {
+		Fmt_Lit(&Out, " ");
+		Fmt_Str(&Out, RefModel_ClassName(Class));
+		Fmt_Lit(&Out, " ");
+		Fmt_Dec(&Out, S->Count[Class]);
+	}
+	Fmt_Lit(&Out, "\r\n");
+	Fmt_Flush(&Out);
+}
+
+/*
+ * Print the first Count kept failing frames (0 for all), one line each.
+ */
+void Soak_Dump(const SoakResult *S, u32 Count)
+{
+	const SoakFailure *F;
+	u32 Class;
+	u32 n;
+	u32 i;
+
+	if (Count == 0 || Count > S->Kept) {
+		Count = S->Kept;
+	}
+	for (n = 0; n < Count; n++) {
+		F = &S->Failure[n];
+		Fmt_Lit(&Out, "#");
+		Fmt_Dec(&Out, F->Cycle);
+		Fmt_Lit(&Out, " cmd");
+		for (i = 0; i < CMD_WORDS; i++) {
+			Fmt_Lit(&Out, " ");
+			Fmt_Hex4(&Out, F->Command[i]);
+		}
+		Fmt_Lit(&Out, " rsp");
+		for (i = 0; i < RSP_WORDS; i++) {
+			Fmt_Lit(&Out, " ");
+			Fmt_Hex4(&Out, F->Response[i]);
+		}
+		for (Class = 0; Class < REF_CLASSES; Class++) {
+			if (F->Mismatch & (1u << Class)) {
+				Fmt_Lit(&Out, " ");
+				Fmt_Str(&Out, RefModel_ClassName(Class));
+			}
+		}
+		Fmt_Lit(&Out, "\r\n");
+		if (Out.Len > FMT_BUF_SIZE - SOAK_LINE_MAX) {
+			Fmt_Flush(&Out);
+		}
+	}
+	Fmt_Flush(&Out);
+}
@@ -0,0 +1,45 @@
+/******************************************************************************
+* soak.h: randomized long-run check of the CPLD against the reference model
+*
+* Soak_Run() sends Cycles COMMAND frames with random command type,
+* threshold, dry/wet, synchronization, relays and SHnum (and, rarely, a
+* reset assert/release), one handshake each, and checks every response with
+* RefModel_Check(). Mismatches are counted per field; only the failing
+* frames are kept, the first SOAK_MAX_FAILURES of them. The random sequence
+* is a function of the seed, so a failing run can be repeated.
+*
+* A progress line is printed every SOAK_PROGRESS_MS; any key stops the run.
+******************************************************************************/
+#ifndef SOAK_H
+#define SOAK_H
+
+#include "fixture.h"
+#include "ref_model.h"
+
+#define SOAK_MAX_FAILURES	256
+#define SOAK_PROGRESS_MS	1000
+#define SOAK_RESET_ODDS		4096	/* One reset toggle per this many frames */
+
+typedef struct {
+	u32 Cycle;
+	u32 Mismatch;			/* REF_ bits */
+	u32 Command[CMD_WORDS];
+	u32 Response[RSP_WORDS];
+} SoakFailure;
+
+typedef struct {
+	u32 Seed;
+	u32 Cycles;				/* Frames sent */
+	u32 Failed;				/* Frames with any mismatch */
+	u32 Lost;				/* Frames without a response */
+	u32 ElapsedUs;
+	u32 Count[REF_CLASSES];	/* Frames per mismatching field */
+	u32 Kept;				/* Entries in Failure */
+	SoakFailure Failure[SOAK_MAX_FAILURES];
+} SoakResult;
+
+int Soak_Run(SoakResult *S, const FixtureConfig *Config, u32 Cycles, u32 Seed);
+void Soak_PrintSummary(const SoakResult *S);
+void Soak_Dump(const SoakResult *S, u32 Count);
+
+#endif
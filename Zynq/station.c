@@ -0,0 +1,187 @@
+/******************************************************************************
+* station.c: several fixtures on one BRAM0/BRAM1 pair
+******************************************************************************/
+#include "station.h"
+#include "bram_cmd.h"
+#include "cmd_queue.h"
+#include "render.h"
+#include "timebase.h"
+#include "uart_cli.h"
+
+static Fixture Fix[FIXTURE_COUNT];
+static u32 Selected;
+
+#if FIXTURE_COUNT > 1
+static CmdQueue Queue;
+static u32 Frames[FIXTURE_COUNT][CMD_WORDS];
+static u32 Responses[FIXTURE_COUNT][RSP_WORDS];
+#endif
+
+void Station_Init(void)
+{
+	u32 k;
+
+	for (k = 0; k < FIXTURE_COUNT; k++) {
+		Fixture_Init(&Fix[k]);
+		Fix[k].Config.Pos = k;
+	}
+	Selected = 0;
+}
+
+void Station_Start(void)
+{
+	u32 k;
+
+	for (k = 0; k < FIXTURE_COUNT; k++) {
+		Fixture_Start(&Fix[k]);
+	}
+}
+
+Fixture *Station_Selected(void)
+{
+	return &Fix[Selected];
+}
+
+u32 Station_SelectedIndex(void)
+{
+	return Selected;
+}
+
+/*
+ * Hand the console over to fixture Index, keeping the output and input modes.
+ */
+int Station_Select(u32 Index)
+{
+	if (Index >= FIXTURE_COUNT) {
+		return XST_FAILURE;
+	}
+	Fix[Index].OutputMode = Fix[Selected].OutputMode;
+	Fix[Index].LineMode = Fix[Selected].LineMode;
+	Selected = Index;
+	Render_Invalidate();
+	return XST_SUCCESS;
+}
+
+/****************************************************************************/
+/**
+*
+* Switch every fixture between single-frame and ping-pong staging. The BRAM0
+* mode register is shared, so the setting is the same for the whole station.
+*
+* @param	Enable is 1 for ping-pong, 0 for one frame per handshake.
+*
+* @return	XST_SUCCESS, or XST_FAILURE if ping-pong is asked for while
+*		several fixtures take turns without the command ring.
+*
+*****************************************************************************/
+int Station_SetPingPong(int Enable)
+{
+	u32 k;
+
+	if (Enable && !STATION_PINGPONG_OK) {
+		return XST_FAILURE;
+	}
+	for (k = 0; k < FIXTURE_COUNT; k++) {
+		Fixture_SetPingPong(&Fix[k], Enable);
+	}
+	return XST_SUCCESS;
+}
+
+/****************************************************************************/
+/**
+*
+* Run one round: one COMMAND frame and response for every fixture.
+*
+* @param	None.
+*
+* @return	XST_SUCCESS, XST_FAILURE if any fixture timed out, or
+*		XST_NO_DATA while a single fixture's ping-pong pipeline fills.
+*
+*****************************************************************************/
+int Station_Cycle(void)
+{
+#if FIXTURE_COUNT == 1
+	return Fixture_Cycle(&Fix[0]);
+#else
+	int Status = XST_SUCCESS;
+	u64 Written;
+	u32 k;
+	u32 i;
+
+	if (!FIXTURE_STATION_RING) {
+		for (k = 0; k < FIXTURE_COUNT; k++) {
+			if (Fixture_Cycle(&Fix[k]) == XST_FAILURE) {
+				Status = XST_FAILURE;
+			}
+		}
+		return Status;
+	}
+
+	for (k = 0; k < FIXTURE_COUNT; k++) {
+		Fixture_Stage(&Fix[k]);
+		for (i = 0; i < CMD_WORDS; i++) {
+			Frames[k][i] = Fix[k].Command[i];
+		}
+	}
+
+	/* Every round starts from an empty ring; sweeps and tests change the mode */
+	CmdQueue_Reset(&Queue);
+	Written = Time_Now();
+	CmdQueue_Run(&Queue, (const u32 (*)[CMD_WORDS])Frames, FIXTURE_COUNT, Responses);
+	BramCmd_SetMode(Fix[0].PingPong ? BRAM_MODE_PINGPONG : BRAM_MODE_SINGLE);
+
+	for (k = 0; k < FIXTURE_COUNT; k++) {
+		Fixture_Complete(&Fix[k], Responses[k], Written);
+		if (Fix[k].Status != XST_SUCCESS) {
+			Status = XST_FAILURE;
+		}
+	}
+	return Status;
+#endif
+}
+
+void Station_Report(void)
+{
+	u32 k;
+
+	if (Fix[Selected].OutputMode == OUTPUT_TEXT || Fix[Selected].OutputMode == OUTPUT_DELTA) {
+		Fixture_Report(&Fix[Selected]);
+		return;
+	}
+	for (k = 0; k < FIXTURE_COUNT; k++) {
+		Fixture_Report(&Fix[k]);
+	}
+}
+
+/*
+ * Handle everything received since the last call, as keys or as command
+ * lines depending on the selected fixture's LineMode. A key or command may
+ * select another fixture, so the target is looked up again for each one.
+ * Returns 0 once the fixture loop is to stop.
+ */
+int Station_PollInput(void)
+{
+	static char Line[UART_LINE_SIZE];
+	Fixture *F;
+	u8 Key;
+
+	while (1) {
+		F = &Fix[Selected];
+		if (F->LineMode) {
+			if (!UartCli_ReadLine(Line, sizeof(Line), F->OutputMode == OUTPUT_TEXT)) {
+				return 1;
+			}
+			if (!Fixture_HandleLine(F, Line)) {
+				return 0;
+			}
+		}
+		else {
+			if (!UartCli_TryRecvByte(&Key)) {
+				return 1;
+			}
+			if (!Fixture_HandleKey(F, Key)) {
+				return 0;
+			}
+		}
+	}
+}
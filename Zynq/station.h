@@ -0,0 +1,55 @@
+/******************************************************************************
+* station.h: several fixtures on one BRAM0/BRAM1 pair
+*
+* Each fixture has its own Fixture state (threshold, dry/wet, sync, relays,
+* SHnum) and its own POS value in Command1, which the CPLD uses to route the
+* frame. A station cycle is one round-robin round with one frame per fixture:
+* all frames are posted through the command ring (see cmd_queue.h), so the
+* next fixture's frame is already queued while the previous one turns around.
+* Without FIXTURE_STATION_RING the fixtures take turns, one handshake each;
+* they share the two BRAM0 slots and the CPLD response count, so ping-pong
+* staging is only available with the ring or a single fixture.
+*
+* With FIXTURE_COUNT 1 (the default) a station cycle is just Fixture_Cycle().
+*
+* The console controls the selected fixture. In binary output mode every
+* fixture sends its status record per round, and in trace and stats mode every
+* fixture reports; the text and delta views show the selected fixture only.
+******************************************************************************/
+#ifndef STATION_H
+#define STATION_H
+
+#include "fixture.h"
+
+#define STATION_MAX_FIXTURES	8		/* Command1 POS is 3 bits */
+
+#ifndef FIXTURE_COUNT
+#define FIXTURE_COUNT			1
+#endif
+
+#ifndef FIXTURE_STATION_RING
+#define FIXTURE_STATION_RING	1
+#endif
+
+#if FIXTURE_COUNT < 1 || FIXTURE_COUNT > STATION_MAX_FIXTURES || FIXTURE_COUNT > RING_SLOTS
+#error "FIXTURE_COUNT must be 1..8"
+#endif
+
+#define STATION_PINGPONG_OK		(FIXTURE_COUNT == 1 || FIXTURE_STATION_RING)
+
+#if FIXTURE_PINGPONG && !STATION_PINGPONG_OK
+#error "FIXTURE_PINGPONG with several fixtures needs FIXTURE_STATION_RING"
+#endif
+
+void Station_Init(void);
+void Station_Start(void);
+int Station_Cycle(void);
+void Station_Report(void);
+int Station_PollInput(void);
+int Station_SetPingPong(int Enable);
+
+Fixture *Station_Selected(void);
+u32 Station_SelectedIndex(void);
+int Station_Select(u32 Index);
+
+#endif
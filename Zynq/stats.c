@@ -0,0 +1,260 @@
+/******************************************************************************
+* stats.c: per-bit response statistics over a time window
+******************************************************************************/
+#include <string.h>
+#include "stats.h"
+#include "station.h"
+#include "fmt.h"
+#include "timebase.h"
+
+#define STATS_WORST_SH		4		/* SHnum values listed per summary */
+
+#define STATS_ERROR_BITS	(RSP_FRAME_ERROR | RSP_COMMAND_ERROR_BIT | RSP_COIL_ERROR)
+
+static StatsWindow Window[STATION_MAX_FIXTURES];
+static u32 PeriodMs = FIXTURE_STATS_PERIOD_MS;
+static FmtBuf Out;
+
+/* Labels of the data2 bits worth a rate in the summary */
+typedef struct {
+	u8 Bit;
+	FmtText Name;
+} NamedBit;
+
+static const NamedBit ErrorBit[] = {
+	{ 15, FMT_TEXT(" frame ") },
+	{ 14, FMT_TEXT(" command ") },
+	{ 12, FMT_TEXT(" coil ") },
+	{ 13, FMT_TEXT(" 12v-off ") },
+};
+
+static u32 Pack(const Fixture *F)
+{
+	return ((F->Data[1] & 0xFFFF) << STATS_DATA2_SHIFT) |
+			((F->Data[2] & RSP_RELAY_MASK) << STATS_RELAY_SHIFT) |
+			((F->Data[3] & RSP_INPUT_MASK) << STATS_INPUT_SHIFT);
+}
+
+/* Move the bit-sliced counts into the 32-bit totals */
+static void Fold(BitCounter *C)
+{
+	u32 b;
+	u32 k;
+
+	for (b = 0; b < STATS_BITS; b++) {
+		for (k = 0; k < STATS_PLANES; k++) {
+			C->Count[b] += ((C->Plane[k] >> b) & 1) << k;
+		}
+	}
+	for (k = 0; k < STATS_PLANES; k++) {
+		C->Plane[k] = 0;
+	}
+	C->Pending = 0;
+}
+
+/* Add 1 to the count of every bit set in Word */
+static void Add(BitCounter *C, u32 Word)
+{
+	u32 Carry = Word;
+	u32 Next;
+	u32 k;
+
+	for (k = 0; k < STATS_PLANES && Carry != 0; k++) {
+		Next = C->Plane[k] & Carry;
+		C->Plane[k] ^= Carry;
+		Carry = Next;
+	}
+	if (++C->Pending == STATS_FOLD) {
+		Fold(C);
+	}
+}
+
+static StatsWindow *WindowOf(const Fixture *F)
+{
+	return &Window[F->Config.Pos & (STATION_MAX_FIXTURES - 1)];
+}
+
+/* Count an error frame, per SHnum when its Command1 holds a valid one (a
+ * replayed file may carry any byte there) */
+static void CountError(StatsWindow *W, const Fixture *F)
+{
+	u32 Sh = F->Command[1] & 0xFF;
+
+	W->Errors++;
+	if (Sh <= SHNUM_WRAP) {
+		W->ErrorsBySh[Sh]++;
+	}
+}
+
+static void Restart(StatsWindow *W)
+{
+	u32 Prev = W->Prev;
+	u8 Primed = W->Primed;
+
+	memset(W, 0, sizeof(*W));
+	W->Prev = Prev;
+	W->Primed = Primed;
+}
+
+/****************************************************************************/
+/**
+*
+* Count the frame F has just finished into its fixture's window. Called once
+* per frame from the fixture loop.
+*
+* @param	F is the fixture state with the response in F->Data.
+*
+* @return	None.
+*
+*****************************************************************************/
+void Stats_Update(const Fixture *F)
+{
+	StatsWindow *W = WindowOf(F);
+	u32 Word;
+
+	if (W->Cycles++ == 0) {
+		W->Start = Time_Now();
+	}
+	if (F->Status != XST_SUCCESS) {
+		W->Timeouts++;
+		CountError(W, F);
+		return;
+	}
+	if (F->Data[1] & STATS_ERROR_BITS) {
+		CountError(W, F);
+	}
+
+	Word = Pack(F);
+	Add(&W->Set, Word);
+	if (W->Primed) {
+		Add(&W->Toggled, Word ^ W->Prev);
+	}
+	W->Prev = Word;
+	W->Primed = 1;
+}
+
+/* Count and rate in parts per million of the window's frames */
+static void FormatRate(FmtBuf *B, u32 Count, u32 Cycles)
+{
+	Fmt_Dec(B, Count);
+	Fmt_Lit(B, " (");
+	Fmt_Dec(B, Cycles ? (u32)((u64)Count * 1000000 / Cycles) : 0);
+	Fmt_Lit(B, " ppm)");
+}
+
+static void FormatCounts(FmtBuf *B, const FmtText *Label, const BitCounter *C, u32 Shift, u32 Bits)
+{
+	u32 i;
+
+	Fmt_Text(B, Label);
+	for (i = 0; i < Bits; i++) {
+		Fmt_Lit(B, " ");
+		Fmt_Dec(B, C->Count[Shift + i]);
+	}
+}
+
+static void FormatWindow(FmtBuf *B, StatsWindow *W, u32 Pos)
+{
+	static const FmtText RelaysSet = FMT_TEXT("\r\n  relays AA..CC set");
+	static const FmtText RelaysToggled = FMT_TEXT(", toggled");
+	static const FmtText InputsSet = FMT_TEXT("\r\n  inputs 1..7 set");
+	u32 Worst[STATS_WORST_SH];
+	u32 Ms = (u32)Time_TicksToUs(Time_Now() - W->Start) / 1000;
+	u32 Best;
+	u32 i;
+	u32 j;
+	u32 k;
+
+	Fold(&W->Set);
+	Fold(&W->Toggled);
+
+	Fmt_Lit(B, "STATS pos ");
+	Fmt_Dec(B, Pos);
+	Fmt_Lit(B, ": ");
+	Fmt_Dec(B, W->Cycles);
+	Fmt_Lit(B, " frames in ");
+	Fmt_Dec(B, Ms);
+	Fmt_Lit(B, " ms (");
+	Fmt_Dec(B, Ms ? (u32)((u64)W->Cycles * 1000 / Ms) : 0);
+	Fmt_Lit(B, "/s), timeouts ");
+	FormatRate(B, W->Timeouts, W->Cycles);
+
+	Fmt_Lit(B, "\r\n  errors ");
+	for (i = 0; i < sizeof(ErrorBit) / sizeof(ErrorBit[0]); i++) {
+		Fmt_Text(B, &ErrorBit[i].Name);
+		FormatRate(B, W->Set.Count[STATS_DATA2_SHIFT + ErrorBit[i].Bit], W->Cycles);
+	}
+
+	FormatCounts(B, &RelaysSet, &W->Set, STATS_RELAY_SHIFT, 5);
+	FormatCounts(B, &RelaysToggled, &W->Toggled, STATS_RELAY_SHIFT, 5);
+	FormatCounts(B, &InputsSet, &W->Set, STATS_INPUT_SHIFT, 7);
+	FormatCounts(B, &RelaysToggled, &W->Toggled, STATS_INPUT_SHIFT, 7);
+
+	/* The STATS_WORST_SH SHnum values with the most errors, most first */
+	Fmt_Lit(B, "\r\n  errors by SHnum");
+	for (k = 0; k < STATS_WORST_SH; k++) {
+		Best = 0;
+		for (i = 0; i <= SHNUM_WRAP; i++) {
+			for (j = 0; j < k && Worst[j] != i; j++);
+			if (j == k && W->ErrorsBySh[i] > Best) {
+				Best = W->ErrorsBySh[i];
+				Worst[k] = i;
+			}
+		}
+		if (Best == 0) {
+			break;
+		}
+		Fmt_Lit(B, " ");
+		Fmt_Dec(B, Worst[k]);
+		Fmt_Lit(B, ":");
+		Fmt_Dec(B, Best);
+	}
+	if (k == 0) {
+		Fmt_Lit(B, " none");
+	}
+	Fmt_Lit(B, "\r\n");
+}
+
+/*
+ * OUTPUT_STATS report: print and restart F's window once it is
+ * FIXTURE_STATS_PERIOD_MS old, nothing otherwise.
+ */
+void Stats_Report(const Fixture *F)
+{
+	StatsWindow *W = WindowOf(F);
+
+	if (W->Cycles == 0 || Time_Now() - W->Start < Time_UsToTicks((u64)PeriodMs * 1000)) {
+		return;
+	}
+	Stats_Print(F);
+}
+
+/*
+ * Print F's window now and start a new one.
+ */
+void Stats_Print(const Fixture *F)
+{
+	StatsWindow *W = WindowOf(F);
+
+	FormatWindow(&Out, W, F->Config.Pos);
+	Fmt_Flush(&Out);
+	Restart(W);
+}
+
+void Stats_Clear(void)
+{
+	u32 k;
+
+	for (k = 0; k < STATION_MAX_FIXTURES; k++) {
+		Restart(&Window[k]);
+	}
+}
+
+int Stats_SetPeriod(u32 Ms)
+{
+	if (Ms == 0) {
+		return XST_FAILURE;
+	}
+	PeriodMs = Ms;
+	return XST_SUCCESS;
+}
@@ -0,0 +1,59 @@
+/******************************************************************************
+* stats.h: per-bit response statistics over a time window
+*
+* Every finished frame adds its status bits (data2, the relays of data3, the
+* inputs of data4) to two sets of per-bit counters: how often each bit was
+* set and how often it changed since the previous frame. The counters are
+* bit-sliced: STATS_PLANES words hold an 8-bit count for each of the 32 bit
+* positions, so one frame costs a ripple-carry add of a word into the planes
+* (usually one or two AND/XOR steps), and the planes are folded into 32-bit
+* totals every STATS_FOLD frames. Errors are also counted per SHnum, so
+* failures that follow the sample-and-hold position show up.
+*
+* With OUTPUT_STATS selected nothing is sent per frame; every
+* FIXTURE_STATS_PERIOD_MS each fixture prints a short summary of the window
+* and a new window starts.
+******************************************************************************/
+#ifndef STATS_H
+#define STATS_H
+
+#include "fixture.h"
+
+#ifndef FIXTURE_STATS_PERIOD_MS
+#define FIXTURE_STATS_PERIOD_MS		5000
+#endif
+
+#define STATS_PLANES		8
+#define STATS_FOLD			((1u << STATS_PLANES) - 1)	/* Frames before a plane can overflow */
+
+/* Position of each response field in the packed status word */
+#define STATS_DATA2_SHIFT	0		/* data2 bits 15:0 */
+#define STATS_RELAY_SHIFT	16		/* data3 bits 4:0, RELAY_AA..RELAY_CC */
+#define STATS_INPUT_SHIFT	21		/* data4 bits 6:0, Input_1..Input_7 */
+#define STATS_BITS			28
+
+typedef struct {
+	u32 Plane[STATS_PLANES];	/* Bit b of Plane[k] is bit k of the count of bit b */
+	u32 Pending;				/* Words added since the last fold */
+	u32 Count[STATS_BITS];
+} BitCounter;
+
+typedef struct {
+	u64 Start;					/* Time_Now() at the first frame of the window */
+	u32 Cycles;
+	u32 Timeouts;
+	u32 Errors;					/* Frames with an error bit or a timeout */
+	BitCounter Set;
+	BitCounter Toggled;
+	u32 Prev;					/* Packed status word of the last answered frame */
+	u8 Primed;					/* Prev is valid */
+	u32 ErrorsBySh[SHNUM_WRAP + 1];
+} StatsWindow;
+
+void Stats_Update(const Fixture *F);
+void Stats_Report(const Fixture *F);
+void Stats_Print(const Fixture *F);
+void Stats_Clear(void);
+int Stats_SetPeriod(u32 Ms);
+
+#endif
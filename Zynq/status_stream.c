@@ -0,0 +1,71 @@
+/******************************************************************************
+* status_stream.c: fixed-size binary status record, one per handshake cycle
+******************************************************************************/
+#include "status_stream.h"
+#include "uart_cli.h"
+
+static u8 *Put16(u8 *Buf, u32 Value)
+{
+	Buf[0] = (u8)Value;
+	Buf[1] = (u8)(Value >> 8);
+	return Buf + 2;
+}
+
+/****************************************************************************/
+/**
+*
+* Encode the last command frame and response of F into one status record.
+*
+* @param	F is the fixture state after Fixture_Cycle().
+* @param	Buf receives STREAM_RECORD_SIZE bytes.
+*
+* @return	Number of bytes written, STREAM_RECORD_SIZE.
+*
+*****************************************************************************/
+u32 Stream_Encode(const Fixture *F, u8 *Buf)
+{
+	u8 *p = Buf;
+	int i;
+
+	*p++ = STREAM_SYNC0;
+	*p++ = STREAM_SYNC1;
+	p = Put16(p, (u16)(F->Seq - 1));
+	*p++ = (u8)F->Command[1];
+	*p++ = (u8)(((F->Command[1] >> POS_CommandType) & 0x3) |
+			(F->Reset ? STREAM_FLAG_RESET : 0) |
+			(F->Status != XST_SUCCESS ? STREAM_FLAG_TIMEOUT : 0));
+	for (i = 0; i < CMD_WORDS; i++) {
+		p = Put16(p, F->Command[i]);
+	}
+	for (i = 0; i < RSP_WORDS; i++) {
+		p = Put16(p, F->Data[i]);
+	}
+	p = Put16(p, Stream_Crc16(Buf + 2, (u32)(p - Buf) - 2));
+
+	return (u32)(p - Buf);
+}
+
+void Stream_SendRecord(const Fixture *F)
+{
+	u8 Record[STREAM_RECORD_SIZE];
+
+	UartCli_Send(Record, Stream_Encode(F, Record));
+}
+
+/*
+ * CRC-16/CCITT-FALSE: poly 0x1021, init 0xFFFF, no reflection, no final XOR.
+ */
+u16 Stream_Crc16(const u8 *Buf, u32 Len)
+{
+	u16 Crc = 0xFFFF;
+	int Bit;
+
+	while (Len--) {
+		Crc ^= (u16)(*Buf++ << 8);
+		for (Bit = 0; Bit < 8; Bit++) {
+			if (Crc & 0x8000) Crc = (u16)((Crc << 1) ^ 0x1021);
+			else Crc = (u16)(Crc << 1);
+		}
+	}
+	return Crc;
+}
@@ -0,0 +1,34 @@
+/******************************************************************************
+* status_stream.h: fixed-size binary status record, one per handshake cycle
+*
+* Record layout, all multi-byte fields little-endian:
+*
+*   Offset  Size  Field
+*   0       2     Sync 0xA5 0x5A
+*   2       2     Seq, incremented every cycle (wraps at 65536)
+*   4       1     SHnum sent in Command2
+*   5       1     Flags: bits 1:0 CommandType, bit 2 reset released,
+*                 bit 3 handshake timeout (data words are 0)
+*   6       10    Command1..Command5 (low 16 bits each)
+*   16      14    data1..data7
+*   30      2     CRC-16/CCITT-FALSE over bytes 2..29
+*
+* stream_decode.py decodes the records on the host.
+******************************************************************************/
+#ifndef STATUS_STREAM_H
+#define STATUS_STREAM_H
+
+#include "fixture.h"
+
+#define STREAM_SYNC0			0xA5
+#define STREAM_SYNC1			0x5A
+#define STREAM_RECORD_SIZE		32
+
+#define STREAM_FLAG_RESET		0x04
+#define STREAM_FLAG_TIMEOUT		0x08
+
+u32 Stream_Encode(const Fixture *F, u8 *Buf);
+void Stream_SendRecord(const Fixture *F);
+u16 Stream_Crc16(const u8 *Buf, u32 Len);
+
+#endif
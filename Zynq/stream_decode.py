@@ -0,0 +1,132 @@
+#!/usr/bin/env python3
+# Decoder for the binary status records sent by the Cora Z7 fixture application.
+# Record layout is documented in status_stream.h, the sweep blob in sweep.h.
+#   python3 stream_decode.py /dev/ttyUSB1 [baud]      read from a serial port (needs pyserial)
+#   python3 stream_decode.py capture.bin              read a captured file
+import struct
+import sys
+
+SYNC = b'\xa5\x5a'
+RECORD_SIZE = 32
+SWEEP_SYNC = b'\xa5\x5b'
+SWEEP_HEADER = struct.Struct('<HIHHH')   # Points, time us, Command2, Command3, timeouts
+BODY = struct.Struct('<HBB5H7H')   # Seq, SHnum, Flags, Command1..5, data1..7
+COMMAND_TYPES = {0: 'CPLDRev', 1: 'ChangeRequest', 2: 'DataUpdate', 3: '?'}
+THRESHOLDS = {0xC00: '17V', 0x400: '33V', 0x800: '84V', 0x000: '166V'}
+
+def crc16(data: bytes) -> int:   # CRC-16/CCITT-FALSE
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+class StreamDecoder:
+    def __init__(self):
+        self._buf = bytearray()
+        self.crc_errors = 0
+    # Feed raw bytes, returns the list of decoded records
+    def feed(self, data: bytes) -> list:
+        self._buf += data
+        records = []
+        while True:
+            start = self._buf.find(b'\xa5')
+            while start >= 0 and self._buf[start:start + 2] not in (SYNC, SWEEP_SYNC, b'\xa5'):
+                start = self._buf.find(b'\xa5', start + 1)
+            if start < 0:
+                self._buf.clear()
+                return records
+            if self._buf[start:start + 2] == SWEEP_SYNC:
+                sweep = self._sweep(start)
+                if sweep is None:
+                    return records
+                if sweep:
+                    records.append(sweep)
+                continue
+            if len(self._buf) - start < RECORD_SIZE:
+                del self._buf[:start]
+                return records
+            raw = bytes(self._buf[start:start + RECORD_SIZE])
+            crc, = struct.unpack_from('<H', raw, RECORD_SIZE - 2)
+            if crc16(raw[2:RECORD_SIZE - 2]) != crc:
+                self.crc_errors += 1
+                del self._buf[:start + 1]   # resync on the next sync pattern
+                continue
+            del self._buf[:start + RECORD_SIZE]
+            fields = BODY.unpack_from(raw, 2)
+            records.append({'seq': fields[0], 'shnum': fields[1],
+                            'command_type': COMMAND_TYPES[fields[2] & 0x3],
+                            'reset_released': bool(fields[2] & 0x4),
+                            'timeout': bool(fields[2] & 0x8),
+                            'command': list(fields[3:8]), 'data': list(fields[8:15])})
+
+    # Sweep blob at start: None if incomplete, {} if corrupt, else the sweep
+    def _sweep(self, start: int):
+        if len(self._buf) - start < 2 + SWEEP_HEADER.size:
+            del self._buf[:start]
+            return None
+        points, elapsed, command2, command3, timeouts = SWEEP_HEADER.unpack_from(self._buf, start + 2)
+        size = 2 + SWEEP_HEADER.size + 14 * points + 2
+        if points > 256:
+            del self._buf[:start + 1]
+            return {}
+        if len(self._buf) - start < size:
+            del self._buf[:start]
+            return None
+        raw = bytes(self._buf[start:start + size])
+        crc, = struct.unpack_from('<H', raw, size - 2)
+        if crc16(raw[2:size - 2]) != crc:
+            self.crc_errors += 1
+            del self._buf[:start + 1]
+            return {}
+        del self._buf[:start + size]
+        words = struct.unpack_from('<%dH' % (7 * points), raw, 2 + SWEEP_HEADER.size)
+        return {'sweep': True, 'elapsed_us': elapsed, 'timeouts': timeouts,
+                'command': [command2, command3],
+                'data': [list(words[i:i + 7]) for i in range(0, len(words), 7)]}
+
+def describe(rec: dict) -> str:
+    if rec.get('sweep'):
+        lines = ['sweep: {} points in {} us, {} timeouts, command2=0x{:04X} command3=0x{:04X}'.format(
+            len(rec['data']), rec['elapsed_us'], rec['timeouts'], *rec['command'])]
+        lines += ['  sh={:3d} '.format(sh) + ' '.join('{:04X}'.format(w) for w in data)
+                  for sh, data in enumerate(rec['data'])]
+        return '\n'.join(lines)
+    data2, data3, data4 = rec['data'][1], rec['data'][2], rec['data'][3]
+    flags = [name for name, mask in (('FRAME', 0x8000), ('COMMAND', 0x5000), ('COIL', 0x1000))
+             if data2 & mask] + (['TIMEOUT'] if rec['timeout'] else [])
+    return ('pos={pos} seq={seq:5d} sh={shnum:3d} {command_type:13s} thr={thr:4s} {dw} sync={sync} '
+            'relays=0x{relays:02X} inputs=0x{inputs:02X} err={err}').format(
+        thr=THRESHOLDS[data2 & 0xC00], dw='DRY' if data2 & 0x200 else 'WET',
+        sync=int(bool(data2 & 0x100)), relays=data3 & 0x1F, inputs=data4 & 0x7F,
+        err=','.join(flags) or '-', pos=(rec['command'][0] >> 4) & 0x7, **rec)
+
+def main(argv):
+    if len(argv) < 2:
+        print(__doc__ or 'usage: stream_decode.py <serial port | file> [baud]')
+        return 1
+    decoder = StreamDecoder()
+    if argv[1].startswith('/dev/'):
+        import serial
+        source = serial.Serial(argv[1], int(argv[2]) if len(argv) > 2 else 115200, timeout=1)
+    else:
+        source = open(argv[1], 'rb')
+    try:
+        while True:
+            chunk = source.read(4096)
+            if not chunk and not argv[1].startswith('/dev/'):
+                break
+            for rec in decoder.feed(chunk):
+                print(describe(rec))
+    except KeyboardInterrupt:
+        pass
+    finally:
+        source.close()
+    if decoder.crc_errors:
+        print('CRC errors:', decoder.crc_errors)
+    return 0
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -0,0 +1,127 @@
+/******************************************************************************
+* sweep.c: sample-and-hold sweep over SHnum 0..128
+******************************************************************************/
+#include "sweep.h"
+#include "bram_cmd.h"
+#include "cmd_queue.h"
+#include "decode.h"
+#include "status_stream.h"
+#include "timebase.h"
+#include "uart_cli.h"
+
+static u8 Blob[SWEEP_BLOB_SIZE];
+
+static u8 *Put16(u8 *Buf, u32 Value)
+{
+	Buf[0] = (u8)Value;
+	Buf[1] = (u8)(Value >> 8);
+	return Buf + 2;
+}
+
+/****************************************************************************/
+/**
+*
+* Send the COMMAND frames of SHnum 0..SHNUM_WRAP for Config and store every
+* response in T. BRAM0 is left in single-frame mode.
+*
+* @param	T receives the responses, the time taken and the timeouts.
+* @param	Cache is the frame cache of Config.
+* @param	Config is the commanded state to sweep.
+* @param	Ring is 1 to post all frames through the command ring, 0 for one
+*		handshake per point.
+*
+* @return	XST_SUCCESS, or XST_FAILURE if any point timed out.
+*
+*****************************************************************************/
+int Sweep_Run(SweepTable *T, FrameCache *Cache, const FixtureConfig *Config, int Ring)
+{
+	CmdQueue Q;
+	u64 Start;
+	u32 Sh;
+	u32 i;
+
+	BramCmd_CachedFrame(Cache, Config, 0);
+	T->Command2 = Cache->Frame[0][1];
+	T->Command3 = Cache->Frame[0][2];
+	T->Timeouts = 0;
+
+	Start = Time_Now();
+	if (Ring) {
+		CmdQueue_Reset(&Q);
+		CmdQueue_Run(&Q, (const u32 (*)[CMD_WORDS])Cache->Frame, SWEEP_POINTS, T->Data);
+		T->Timeouts = Q.Lost;
+	}
+	else {
+		BramCmd_SetMode(BRAM_MODE_SINGLE);
+		for (Sh = 0; Sh < SWEEP_POINTS; Sh++) {
+			BramCmd_WriteFrame(Cache->Frame[Sh]);
+			if (BramCmd_WaitHandshake(HS_READ_EN,
+					Time_Now() + Time_UsToTicks(FIXTURE_READEN_TIMEOUT_US)) == XST_SUCCESS) {
+				BramCmd_ReadFrame(T->Data[Sh]);
+			}
+			else {
+				for (i = 0; i < RSP_WORDS; i++) {
+					T->Data[Sh][i] = 0;
+				}
+				T->Timeouts++;
+			}
+		}
+	}
+	T->ElapsedUs = (u32)Time_TicksToUs(Time_Now() - Start);
+	BramCmd_SetMode(BRAM_MODE_SINGLE);
+
+	return T->Timeouts ? XST_FAILURE : XST_SUCCESS;
+}
+
+/*
+ * Encode T as one binary blob, see sweep.h. Buf must hold SWEEP_BLOB_SIZE
+ * bytes.
+ */
+u32 Sweep_Encode(const SweepTable *T, u8 *Buf)
+{
+	u8 *p = Buf;
+	u32 Sh;
+	u32 i;
+
+	*p++ = STREAM_SYNC0;
+	*p++ = SWEEP_SYNC1;
+	p = Put16(p, SWEEP_POINTS);
+	p = Put16(p, T->ElapsedUs);
+	p = Put16(p, T->ElapsedUs >> 16);
+	p = Put16(p, T->Command2);
+	p = Put16(p, T->Command3);
+	p = Put16(p, T->Timeouts);
+	for (Sh = 0; Sh < SWEEP_POINTS; Sh++) {
+		for (i = 0; i < RSP_WORDS; i++) {
+			p = Put16(p, T->Data[Sh][i]);
+		}
+	}
+	p = Put16(p, Stream_Crc16(Buf + 2, (u32)(p - Buf) - 2));
+
+	return (u32)(p - Buf);
+}
+
+void Sweep_Send(const SweepTable *T)
+{
+	UartCli_Send(Blob, Sweep_Encode(T, Blob));
+}
+
+void Sweep_PrintSummary(const SweepTable *T)
+{
+	DecodeCounts Counts;
+	u32 Inputs = 0;
+	u32 b;
+
+	Decode_Batch((const u32 (*)[RSP_WORDS])T->Data, SWEEP_POINTS, NULL, &Counts);
+	for (b = 0; b < DECODE_INPUT_BITS; b++) {
+		if (Counts.Input[b] != 0) Inputs |= 1u << b;
+	}
+
+	xil_printf("SWEEP: %d points in %d us, %d timeouts\r\n",
+			SWEEP_POINTS, T->ElapsedUs, T->Timeouts);
+	xil_printf("  FRAME ERROR: %d  COMMAND ERROR: %d  COIL ERROR: %d  inputs seen: 0x%02X\r\n",
+			Counts.Flag[DECODE_FRAME], Counts.Flag[DECODE_COMMAND], Counts.Flag[DECODE_COIL], Inputs);
+	xil_printf("  166V/33V/84V/17V: %d/%d/%d/%d  DRY: %d  SYNC: %d\r\n",
+			Counts.Threshold[0], Counts.Threshold[1], Counts.Threshold[2], Counts.Threshold[3],
+			Counts.Flag[DECODE_DRY], Counts.Flag[DECODE_SYNC]);
+}
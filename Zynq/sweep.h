@@ -0,0 +1,48 @@
+/******************************************************************************
+* sweep.h: sample-and-hold sweep over SHnum 0..128
+*
+* Sweep_Run() sends the frames of every SHnum back to back, as fast as the
+* handshake allows, and keeps all data1..data7 responses in a table. The
+* result goes out either as a short text summary or as one binary blob:
+*
+*   Offset  Size  Field
+*   0       2     Sync 0xA5 0x5B
+*   2       2     Number of points N (SWEEP_POINTS)
+*   4       4     Sweep time in microseconds
+*   8       2     Command2 of SHnum 0
+*   10      2     Command3
+*   12      2     Handshake timeouts (their data words are 0)
+*   14      14*N  data1..data7 of SHnum 0..N-1
+*   14+14N  2     CRC-16/CCITT-FALSE over bytes 2..13+14N
+*
+* All multi-byte fields are little-endian; stream_decode.py decodes the blob
+* alongside the per-cycle status records.
+******************************************************************************/
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include "fixture.h"
+
+#define SWEEP_SYNC1			0x5B
+#define SWEEP_POINTS		(SHNUM_WRAP + 1)
+#define SWEEP_BLOB_SIZE		(16 + 2 * RSP_WORDS * SWEEP_POINTS)
+
+/* Send the sweep through the command ring instead of one handshake per point */
+#ifndef FIXTURE_SWEEP_RING
+#define FIXTURE_SWEEP_RING	0
+#endif
+
+typedef struct {
+	u32 Command2;			/* Of SHnum 0 */
+	u32 Command3;
+	u32 Data[SWEEP_POINTS][RSP_WORDS];
+	u32 ElapsedUs;
+	u32 Timeouts;
+} SweepTable;
+
+int Sweep_Run(SweepTable *T, FrameCache *Cache, const FixtureConfig *Config, int Ring);
+u32 Sweep_Encode(const SweepTable *T, u8 *Buf);
+void Sweep_Send(const SweepTable *T);
+void Sweep_PrintSummary(const SweepTable *T);
+
+#endif
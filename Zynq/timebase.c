@@ -0,0 +1,199 @@
+/******************************************************************************
+* timebase.c: free-running time base for timestamps and short delays
+******************************************************************************/
+#ifdef FIXTURE_HOST
+#define _POSIX_C_SOURCE 200809L
+#include <time.h>
+#endif
+
+#include "timebase.h"
+
+#ifndef FIXTURE_HOST
+#include "xparameters.h"
+#include "xil_io.h"
+#include "xtime_l.h"
+#include "xil_exception.h"
+#include "xpseudo_asm.h"
+#include "intc.h"
+
+#define GTIMER_ISR_OFFSET			0x0C
+#define GTIMER_COMP_LOWER_OFFSET	0x10
+#define GTIMER_COMP_UPPER_OFFSET	0x14
+#define GTIMER_CTRL_COMP_ENABLE		0x02
+#define GTIMER_CTRL_IRQ_ENABLE		0x04
+#define GTIMER_INTR					XPS_GLOBAL_TMR_INT_ID
+
+static int WakeupReady;
+
+u64 Time_Now(void)
+{
+	XTime Now;
+
+	XTime_GetTime(&Now);
+	return Now;
+}
+
+u64 Time_TicksPerSecond(void)
+{
+	return COUNTS_PER_SECOND;
+}
+
+/* xil-crt0.S resets the global timer to 0 before main() */
+u32 Time_SinceResetUs(void)
+{
+	return (u32)Time_TicksToUs(Time_Now());
+}
+
+static void WakeupIsr(void *CallBackRef)
+{
+	(void)CallBackRef;
+	Time_DisarmWakeup();
+	Xil_Out32(GLOBAL_TMR_BASEADDR + GTIMER_ISR_OFFSET, 1);
+}
+
+int Time_InitWakeup(void)
+{
+	int Status;
+
+	Status = Intc_Init();
+	if (Status != XST_SUCCESS) {
+		return XST_FAILURE;
+	}
+	Status = Intc_Connect(GTIMER_INTR, WakeupIsr, NULL);
+	WakeupReady = Status == XST_SUCCESS;
+	return Status;
+}
+
+/*
+ * Interrupt once the global timer reaches Deadline (Time_Now() ticks).
+ */
+void Time_ArmWakeup(u64 Deadline)
+{
+	u32 Control = Xil_In32(GLOBAL_TMR_BASEADDR + GTIMER_CONTROL_OFFSET);
+
+	Control &= ~(GTIMER_CTRL_COMP_ENABLE | GTIMER_CTRL_IRQ_ENABLE);
+	Xil_Out32(GLOBAL_TMR_BASEADDR + GTIMER_CONTROL_OFFSET, Control);
+	Xil_Out32(GLOBAL_TMR_BASEADDR + GTIMER_COMP_LOWER_OFFSET, (u32)Deadline);
+	Xil_Out32(GLOBAL_TMR_BASEADDR + GTIMER_COMP_UPPER_OFFSET, (u32)(Deadline >> 32));
+	Xil_Out32(GLOBAL_TMR_BASEADDR + GTIMER_CONTROL_OFFSET,
+			Control | GTIMER_CTRL_COMP_ENABLE | GTIMER_CTRL_IRQ_ENABLE);
+}
+
+void Time_DisarmWakeup(void)
+{
+	u32 Control = Xil_In32(GLOBAL_TMR_BASEADDR + GTIMER_CONTROL_OFFSET);
+
+	Xil_Out32(GLOBAL_TMR_BASEADDR + GTIMER_CONTROL_OFFSET,
+			Control & ~(GTIMER_CTRL_COMP_ENABLE | GTIMER_CTRL_IRQ_ENABLE));
+}
+
+/*
+ * Sleep in WFI until Deadline, woken by the global timer comparator. Without
+ * the wakeup interrupt it spins.
+ */
+void Time_WaitUntil(u64 Deadline)
+{
+	if (!WakeupReady) {
+		while (Time_Now() < Deadline);
+		return;
+	}
+	Time_ArmWakeup(Deadline);
+	while (Time_Now() < Deadline) {
+		Xil_ExceptionDisable();
+		if (Time_Now() < Deadline) {
+			wfi();
+		}
+		Xil_ExceptionEnable();
+	}
+	Time_DisarmWakeup();
+}
+
+#else /* FIXTURE_HOST */
+
+static u64 ResetTime;
+static int Replaying;
+static u64 ReplayClock;
+
+u64 Time_Now(void)
+{
+	struct timespec Now;
+
+	if (Replaying) {
+		return ReplayClock;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &Now);
+	return (u64)Now.tv_sec * 1000000000ull + (u64)Now.tv_nsec;
+}
+
+u64 Time_TicksPerSecond(void)
+{
+	return 1000000000ull;
+}
+
+__attribute__((constructor)) static void MarkReset(void)
+{
+	ResetTime = Time_Now();
+}
+
+u32 Time_SinceResetUs(void)
+{
+	return (u32)Time_TicksToUs(Time_Now() - ResetTime);
+}
+
+/*
+ * From now on Time_Now() returns Now, the time since the start of the
+ * recording being replayed, which is also the time since reset.
+ */
+void Time_Replay(u64 Now)
+{
+	Replaying = 1;
+	ResetTime = 0;
+	ReplayClock = Now;
+}
+
+/* The host backends poll, nothing to wake */
+int Time_InitWakeup(void)
+{
+	return XST_SUCCESS;
+}
+
+void Time_ArmWakeup(u64 Deadline)
+{
+	(void)Deadline;
+}
+
+void Time_DisarmWakeup(void)
+{
+}
+
+/* Spin: a sleep would add the scheduler's wake-up latency to every step */
+void Time_WaitUntil(u64 Deadline)
+{
+	while (Time_Now() < Deadline);
+}
+
+#endif
+
+u64 Time_TicksToUs(u64 Ticks)
+{
+	u64 PerSecond = Time_TicksPerSecond();
+
+	return (Ticks / PerSecond) * 1000000ull + (Ticks % PerSecond) * 1000000ull / PerSecond;
+}
+
+u64 Time_UsToTicks(u64 Us)
+{
+	u64 PerSecond = Time_TicksPerSecond();
+
+	return (Us / 1000000ull) * PerSecond + (Us % 1000000ull) * PerSecond / 1000000ull;
+}
+
+/*
+ * Busy-wait for Us microseconds against the time base.
+ */
+void Time_DelayUs(u32 Us)
+{
+	u64 End = Time_Now() + Time_UsToTicks(Us);
+
+	while (Time_Now() < End);
+}
@@ -0,0 +1,39 @@
+/******************************************************************************
+* timebase.h: free-running time base for timestamps and short delays
+*
+* The board build reads the Cortex-A9 global timer (XTime_GetTime, counting at
+* COUNTS_PER_SECOND); the host build reads CLOCK_MONOTONIC in nanoseconds.
+* Either way the result does not depend on the optimization level.
+* Time_SinceResetUs() counts from the start of the application: the board
+* start-up code zeroes the global timer, the host marks process start.
+*
+* Time_ArmWakeup() raises an interrupt at an absolute time (global timer
+* comparator) so code sleeping in WFI with a deadline is woken on time;
+* Time_WaitUntil() sleeps that way until an absolute time.
+*
+* Host only: after Time_Replay() the clock is the one of a recorded session,
+* set by replay_host.c before every frame, so time-based views replay the
+* same way however fast the frames are fed.
+******************************************************************************/
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+#include "fixture.h"
+
+u64 Time_Now(void);
+u64 Time_TicksPerSecond(void);
+u64 Time_TicksToUs(u64 Ticks);
+u64 Time_UsToTicks(u64 Us);
+void Time_DelayUs(u32 Us);
+u32 Time_SinceResetUs(void);
+
+int Time_InitWakeup(void);
+void Time_ArmWakeup(u64 Deadline);
+void Time_DisarmWakeup(void);
+void Time_WaitUntil(u64 Deadline);
+
+#ifdef FIXTURE_HOST
+void Time_Replay(u64 Now);
+#endif
+
+#endif
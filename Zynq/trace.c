@@ -0,0 +1,217 @@
+/******************************************************************************
+* trace.c: post-mortem history of every handshake cycle
+******************************************************************************/
+#include "trace.h"
+#include "station.h"
+#include "fmt.h"
+#include "timebase.h"
+
+#define TRACE_MASK				(TRACE_RECORDS - 1)
+#define TRACE_LINE_MAX			160		/* Longest Trace line, for flushing */
+
+#if TRACE_RECORDS & TRACE_MASK
+#error "FIXTURE_TRACE_RECORDS must be a power of two"
+#endif
+
+static TraceRecord Ring[TRACE_RECORDS];
+static u32 Head;						/* Records written, free running */
+static u32 ErrorCount;
+static u32 LastOfPos[STATION_MAX_FIXTURES];	/* Head of the last record per POS */
+static int Enabled = FIXTURE_TRACE;
+static FmtBuf Out;
+
+static u8 ErrorBits(u32 Data2, int Status)
+{
+	u8 Errors = 0;
+
+	if (Data2 & RSP_FRAME_ERROR) Errors |= TRACE_FRAME_ERROR;
+	if (Data2 & RSP_COMMAND_ERROR_BIT) Errors |= TRACE_COMMAND_ERROR;
+	if (Data2 & RSP_COIL_ERROR) Errors |= TRACE_COIL_ERROR;
+	if (Status != XST_SUCCESS) Errors |= TRACE_TIMEOUT;
+	return Errors;
+}
+
+/****************************************************************************/
+/**
+*
+* Append the frame F has just finished to the trace. Called once per frame
+* from the fixture loop, so it only copies.
+*
+* @param	F is the fixture state with the response in F->Data.
+* @param	Now is the Time_Now() value the frame finished at.
+*
+* @return	None.
+*
+*****************************************************************************/
+void Trace_Record(const Fixture *F, u64 Now)
+{
+	TraceRecord *R;
+	int i;
+
+	if (!Enabled) {
+		return;
+	}
+	R = &Ring[Head & TRACE_MASK];
+	R->Time = Now;
+	R->TurnaroundUs = F->TurnaroundUs;
+	R->Seq = F->Seq;
+	R->Errors = ErrorBits(F->Data[1], F->Status);
+	for (i = 0; i < CMD_WORDS; i++) {
+		R->Command[i] = (u16)F->Command[i];
+	}
+	for (i = 0; i < RSP_WORDS; i++) {
+		R->Data[i] = (u16)F->Data[i];
+	}
+	if (R->Errors) {
+		ErrorCount++;
+	}
+	LastOfPos[F->Config.Pos & (STATION_MAX_FIXTURES - 1)] = Head;
+	Head++;
+}
+
+void Trace_Enable(int Enable)
+{
+	Enabled = Enable;
+}
+
+int Trace_IsEnabled(void)
+{
+	return Enabled;
+}
+
+void Trace_Clear(void)
+{
+	u32 k;
+
+	Head = 0;
+	ErrorCount = 0;
+	for (k = 0; k < STATION_MAX_FIXTURES; k++) {
+		LastOfPos[k] = 0;
+	}
+}
+
+static u32 Held(void)
+{
+	return Head < TRACE_RECORDS ? Head : TRACE_RECORDS;
+}
+
+/* One line per record, timestamped in microseconds since reset */
+static void FormatRecord(FmtBuf *B, const TraceRecord *R)
+{
+	int i;
+
+	Fmt_Lit(B, "T ");
+	Fmt_Dec(B, Time_SinceResetUs() - (u32)Time_TicksToUs(Time_Now() - R->Time));
+	Fmt_Lit(B, " us seq ");
+	Fmt_Dec(B, R->Seq);
+	Fmt_Lit(B, " pos ");
+	Fmt_Dec(B, (R->Command[0] >> POS_Pos) & 0x7);
+	Fmt_Lit(B, " sh ");
+	Fmt_Dec(B, R->Command[1] & 0xFF);
+	Fmt_Lit(B, " ta ");
+	Fmt_Dec(B, R->TurnaroundUs);
+	Fmt_Lit(B, " us cmd");
+	for (i = 0; i < CMD_WORDS; i++) {
+		Fmt_Lit(B, " ");
+		Fmt_Hex4(B, R->Command[i]);
+	}
+	Fmt_Lit(B, " rsp");
+	for (i = 0; i < RSP_WORDS; i++) {
+		Fmt_Lit(B, " ");
+		Fmt_Hex4(B, R->Data[i]);
+	}
+	if (R->Errors & TRACE_FRAME_ERROR) Fmt_Lit(B, " FRAME");
+	if (R->Errors & TRACE_COMMAND_ERROR) Fmt_Lit(B, " COMMAND");
+	if (R->Errors & TRACE_COIL_ERROR) Fmt_Lit(B, " COIL");
+	if (R->Errors & TRACE_TIMEOUT) Fmt_Lit(B, " TIMEOUT");
+	Fmt_Lit(B, "\r\n");
+}
+
+/*
+ * OUTPUT_TRACE report: print the last frame of F only if it had an error.
+ */
+void Trace_Report(const Fixture *F)
+{
+	const TraceRecord *R;
+	u32 Index;
+
+	if (!Enabled || Head == 0) {
+		return;
+	}
+	Index = LastOfPos[F->Config.Pos & (STATION_MAX_FIXTURES - 1)];
+	R = &Ring[Index & TRACE_MASK];
+	if (R->Errors == 0 || Head - Index > TRACE_RECORDS ||
+			((R->Command[0] >> POS_Pos) & 0x7) != F->Config.Pos) {
+		return;
+	}
+	FormatRecord(&Out, R);
+	Fmt_Flush(&Out);
+}
+
+void Trace_PrintStatus(void)
+{
+	Fmt_Lit(&Out, "TRACE ");
+	if (Enabled) {
+		Fmt_Lit(&Out, "on, ");
+	}
+	else Fmt_Lit(&Out, "off, ");
+	Fmt_Dec(&Out, Held());
+	Fmt_Lit(&Out, " of ");
+	Fmt_Dec(&Out, TRACE_RECORDS);
+	Fmt_Lit(&Out, " records held, ");
+	Fmt_Dec(&Out, Head);
+	Fmt_Lit(&Out, " recorded, ");
+	Fmt_Dec(&Out, ErrorCount);
+	Fmt_Lit(&Out, " with errors\r\n");
+	Fmt_Flush(&Out);
+}
+
+/****************************************************************************/
+/**
+*
+* Print the most recent Count records that match Filter, oldest first, one
+* line each. Output waits for the UART, so a long dump stalls the loop for
+* as long as it takes to send.
+*
+* @param	Filter is TRACE_ALL, or the TRACE_*_ERROR bits of which a record
+*		must have at least one.
+* @param	Count is the maximum number of records to print, 0 for all.
+*
+* @return	Number of records printed.
+*
+*****************************************************************************/
+u32 Trace_Dump(u32 Filter, u32 Count)
+{
+	const TraceRecord *R;
+	u32 Oldest = Head - Held();
+	u32 First = Head;
+	u32 Found = 0;
+	u32 Index;
+
+	if (Count == 0) {
+		Count = TRACE_RECORDS;
+	}
+	/* Walk back to the oldest of the Count newest matches ... */
+	while (First != Oldest && Found < Count) {
+		First--;
+		if (Filter == TRACE_ALL || (Ring[First & TRACE_MASK].Errors & Filter)) {
+			Found++;
+		}
+	}
+	/* ... and print forward from there */
+	for (Index = First; Index != Head; Index++) {
+		R = &Ring[Index & TRACE_MASK];
+		if (Filter != TRACE_ALL && !(R->Errors & Filter)) {
+			continue;
+		}
+		FormatRecord(&Out, R);
+		if (Out.Len > FMT_BUF_SIZE - TRACE_LINE_MAX) {
+			Fmt_Flush(&Out);
+		}
+	}
+	Fmt_Lit(&Out, "TRACE DUMP ");
+	Fmt_Dec(&Out, Found);
+	Fmt_Lit(&Out, " records\r\n");
+	Fmt_Flush(&Out);
+	return Found;
+}
@@ -0,0 +1,57 @@
+/******************************************************************************
+* trace.h: post-mortem history of every handshake cycle
+*
+* Each finished frame (every fixture of a station) is copied into a ring of
+* TRACE_RECORDS records: completion timestamp, command and response words,
+* turnaround and timeout flag. Nothing is printed while recording. On the
+* Standalone BSP the ring is an ordinary .bss array, which the linker script
+* places in DDR (10 MB with the default size); the oldest records are
+* overwritten once it is full.
+*
+* With OUTPUT_TRACE selected the per-cycle report prints one line for cycles
+* with a FRAME, COMMAND or COIL ERROR bit or a handshake timeout, and nothing
+* otherwise. The "dump" command line prints the history, all of it or only
+* the records with a given error, see Trace_Dump().
+******************************************************************************/
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "fixture.h"
+
+#ifndef FIXTURE_TRACE
+#define FIXTURE_TRACE			1
+#endif
+
+#ifndef FIXTURE_TRACE_RECORDS
+#define FIXTURE_TRACE_RECORDS	(1u << 18)	/* Power of two */
+#endif
+
+#define TRACE_RECORDS			FIXTURE_TRACE_RECORDS
+
+/* Trace_Dump() filters, bits of the error mask of a record */
+#define TRACE_FRAME_ERROR		0x01
+#define TRACE_COMMAND_ERROR		0x02
+#define TRACE_COIL_ERROR		0x04
+#define TRACE_TIMEOUT			0x08
+#define TRACE_ANY_ERROR			0x0F
+#define TRACE_ALL				0x00	/* No filter */
+
+typedef struct {
+	u64 Time;				/* Time_Now() when the frame finished */
+	u32 TurnaroundUs;
+	u16 Seq;				/* Fixture.Seq of the frame */
+	u8 Errors;				/* TRACE_FRAME_ERROR..TRACE_TIMEOUT */
+	u8 Reserved;
+	u16 Command[CMD_WORDS];
+	u16 Data[RSP_WORDS];
+} TraceRecord;
+
+void Trace_Record(const Fixture *F, u64 Now);
+void Trace_Enable(int Enable);
+int Trace_IsEnabled(void);
+void Trace_Clear(void);
+void Trace_Report(const Fixture *F);
+void Trace_PrintStatus(void);
+u32 Trace_Dump(u32 Filter, u32 Count);
+
+#endif
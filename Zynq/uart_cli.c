@@ -1 +1,689 @@
+/******************************************************************************
+* uart_cli.c: PS UART access for the fixture console
+*
+* Received bytes are moved into RxRing by the UART interrupt (or, on the host,
+* by polling stdin) so the fixture loop never blocks on the receiver and no
+* keystroke typed during a long cycle is lost.
+*
+* On the board, output is queued in TxRing and drained into the TX FIFO by the
+* TX-empty interrupt, so sending costs a copy into RAM. outbyte() is replaced
+* as well, so xil_printf output takes the same path.
+*
+* The line interpreter and its macros only use the receive ring, so they are
+* the same for both backends.
+******************************************************************************/
+#ifdef FIXTURE_HOST
+#define _POSIX_C_SOURCE 200809L
+#include <poll.h>
+#include <unistd.h>
+#endif
 
+#include <stdlib.h>
+#include <string.h>
+#include "uart_cli.h"
+#include "intc.h"
+
+#define RX_RING_MASK		(UART_RX_RING_SIZE - 1)
+
+static volatile u8 RxRing[UART_RX_RING_SIZE];
+static volatile u32 RxHead;			/* Written by the producer (ISR) only */
+static volatile u32 RxTail;			/* Written by the consumer only */
+static volatile u32 RxOverruns;
+
+static void RxPoll(void);
+
+static void RxPut(u8 Byte)
+{
+	u32 Next = (RxHead + 1) & RX_RING_MASK;
+
+	if (Next == RxTail) {
+		RxOverruns++;
+		return;
+	}
+	RxRing[RxHead] = Byte;
+	RxHead = Next;
+}
+
+int UartCli_TryRecvByte(u8 *Byte)
+{
+	RxPoll();
+	if (RxHead == RxTail) {
+		return FALSE;
+	}
+	*Byte = RxRing[RxTail];
+	RxTail = (RxTail + 1) & RX_RING_MASK;
+	return TRUE;
+}
+
+/*
+ * Take the next received byte only if it is UART_CANCEL; anything else stays
+ * for the line reader, so a pasted script is not cut short by a long command.
+ */
+int UartCli_TryRecvCancel(void)
+{
+	RxPoll();
+	if (RxHead == RxTail || RxRing[RxTail] != UART_CANCEL) {
+		return FALSE;
+	}
+	RxTail = (RxTail + 1) & RX_RING_MASK;
+	return TRUE;
+}
+
+int UartCli_IsReceiveData(void)
+{
+	RxPoll();
+	return RxHead != RxTail;
+}
+
+u8 UartCli_RecvByte(void)
+{
+	u8 Byte;
+
+	while (!UartCli_TryRecvByte(&Byte)) {
+		if (!UartCli_IsOpen()) {
+			return '0';
+		}
+	}
+	return Byte;
+}
+
+u32 UartCli_RxOverruns(void)
+{
+	return RxOverruns;
+}
+
+static const u32 BaudTable[] = { UART_BAUD_TABLE };
+static u32 BaudRate;
+
+u32 UartCli_BaudRate(void)
+{
+	return BaudRate;
+}
+
+/*
+ * Step to the next rate of UART_BAUD_TABLE, wrapping to the first one.
+ */
+int UartCli_NextBaudRate(void)
+{
+	u32 i;
+
+	for (i = 0; i < sizeof(BaudTable) / sizeof(BaudTable[0]) - 1; i++) {
+		if (BaudTable[i] == BaudRate) {
+			return UartCli_SetBaudRate(BaudTable[i + 1]);
+		}
+	}
+	return UartCli_SetBaudRate(BaudTable[0]);
+}
+
+/////////////////////////////////// COMMAND LINES ////////////////////////////////////////////////
+typedef struct {
+	char Name[UART_MACRO_NAME];
+	char Text[UART_MACRO_SIZE];		/* Lines, each ended by '\n' */
+	u32 Len;
+} Macro;
+
+static char LineBuf[UART_LINE_SIZE];
+static u32 LineLen;
+static Macro Macros[UART_MACROS];
+static Macro *Recording;
+static u32 Depth;
+
+/****************************************************************************/
+/**
+*
+* Collect received bytes into a command line without waiting. CR or LF ends
+* the line, backspace and DEL remove the last character, empty lines are
+* skipped and characters past the line size are dropped.
+*
+* @param	Line receives the completed line, NUL terminated.
+* @param	Size is the size of Line.
+* @param	Echo is 1 to echo what is typed.
+*
+* @return	TRUE when Line holds a new line, FALSE when no complete line
+*		has been received yet.
+*
+*****************************************************************************/
+int UartCli_ReadLine(char *Line, u32 Size, int Echo)
+{
+	u8 Byte;
+
+	while (UartCli_TryRecvByte(&Byte)) {
+		if (Byte == '\r' || Byte == '\n') {
+			if (LineLen == 0) {
+				continue;
+			}
+			if (Echo) xil_printf("\r\n");
+			if (LineLen > Size - 1) {
+				LineLen = Size - 1;
+			}
+			memcpy(Line, LineBuf, LineLen);
+			Line[LineLen] = '\0';
+			LineLen = 0;
+			return TRUE;
+		}
+		if (Byte == 0x08 || Byte == 0x7F) {
+			if (LineLen > 0) {
+				LineLen--;
+				if (Echo) xil_printf("\b \b");
+			}
+			continue;
+		}
+		if (LineLen < sizeof(LineBuf) - 1) {
+			LineBuf[LineLen++] = (char)Byte;
+			if (Echo) xil_printf("%c", Byte);
+		}
+	}
+	return FALSE;
+}
+
+int UartCli_IsRecording(void)
+{
+	return Recording != NULL;
+}
+
+static Macro *FindMacro(const char *Name)
+{
+	u32 i;
+
+	for (i = 0; i < UART_MACROS; i++) {
+		if (Macros[i].Name[0] != '\0' && strcmp(Macros[i].Name, Name) == 0) {
+			return &Macros[i];
+		}
+	}
+	return NULL;
+}
+
+static int DefineMacro(const char *Name)
+{
+	Macro *M = FindMacro(Name);
+	u32 i;
+
+	for (i = 0; M == NULL && i < UART_MACROS; i++) {
+		if (Macros[i].Name[0] == '\0') {
+			M = &Macros[i];
+		}
+	}
+	if (M == NULL || strlen(Name) >= UART_MACRO_NAME) {
+		xil_printf("ERR no room for macro %s\r\n", Name);
+		return XST_FAILURE;
+	}
+	strcpy(M->Name, Name);
+	M->Len = 0;
+	Recording = M;
+	return XST_SUCCESS;
+}
+
+static int Record(const char *Line)
+{
+	u32 Len = strlen(Line);
+
+	if (Recording->Len + Len + 1 > UART_MACRO_SIZE) {
+		xil_printf("ERR macro %s full\r\n", Recording->Name);
+		return XST_FAILURE;
+	}
+	memcpy(&Recording->Text[Recording->Len], Line, Len);
+	Recording->Len += Len;
+	Recording->Text[Recording->Len++] = '\n';
+	return XST_SUCCESS;
+}
+
+/*
+ * Run the lines of macro M Count times, stopping at the first failing one.
+ */
+static int Replay(const UartCli_Command *Table, Macro *M, u32 Count, void *Ref)
+{
+	char Line[UART_LINE_SIZE];
+	u32 Pos;
+	u32 Len;
+	int Status = XST_SUCCESS;
+
+	if (Depth >= UART_MACRO_DEPTH) {
+		xil_printf("ERR macros nested too deep\r\n");
+		return XST_FAILURE;
+	}
+	Depth++;
+	while (Count-- && Status == XST_SUCCESS) {
+		for (Pos = 0; Pos < M->Len && Status == XST_SUCCESS; Pos += Len + 1) {
+			Len = (u32)((char *)memchr(&M->Text[Pos], '\n', M->Len - Pos) - &M->Text[Pos]);
+			memcpy(Line, &M->Text[Pos], Len);
+			Line[Len] = '\0';
+			Status = UartCli_Execute(Table, Line, Ref);
+		}
+	}
+	Depth--;
+	return Status;
+}
+
+static void Help(const UartCli_Command *Table)
+{
+	for (; Table->Name != NULL; Table++) {
+		xil_printf("  %s %s\r\n", Table->Name, Table->Usage);
+	}
+	xil_printf("  def NAME | end | do NAME [N] | macros\r\n");
+}
+
+/****************************************************************************/
+/**
+*
+* Split Line into words and run it: a macro command, or the entry of Table
+* named by the first word. While a macro is being defined, lines other than
+* "end" are stored in it instead.
+*
+* @param	Table is the command table, ended by an entry with a NULL Name.
+* @param	Line is the command line; it is modified.
+* @param	Ref is passed to the handlers.
+*
+* @return	The handler's status, XST_SUCCESS for an empty line, or
+*		XST_FAILURE for an unknown command, missing arguments or a
+*		bad repeat count.
+*
+*****************************************************************************/
+int UartCli_Execute(const UartCli_Command *Table, char *Line, void *Ref)
+{
+	char *Argv[UART_MAX_ARGS];
+	int Argc = 0;
+	char *p = Line;
+	char *End;
+	unsigned long Count = 1;
+	Macro *M;
+
+	while (*p == ' ' || *p == '\t') p++;
+	if (Recording != NULL) {
+		if (strcmp(p, "end") != 0) {
+			return Record(p);
+		}
+		Recording = NULL;
+		return XST_SUCCESS;
+	}
+
+	while (*p != '\0' && Argc < UART_MAX_ARGS) {
+		Argv[Argc++] = p;
+		while (*p != '\0' && *p != ' ' && *p != '\t') p++;
+		while (*p == ' ' || *p == '\t') *p++ = '\0';
+	}
+	if (Argc == 0 || Argv[0][0] == '#') {
+		return XST_SUCCESS;
+	}
+
+	if (strcmp(Argv[0], "def") == 0 && Argc == 2) {
+		return DefineMacro(Argv[1]);
+	}
+	if (strcmp(Argv[0], "do") == 0 && Argc >= 2) {
+		M = FindMacro(Argv[1]);
+		if (M == NULL) {
+			xil_printf("ERR no macro %s\r\n", Argv[1]);
+			return XST_FAILURE;
+		}
+		if (Argc > 2) {
+			Count = strtoul(Argv[2], &End, 0);
+			if (Argv[2][0] < '0' || Argv[2][0] > '9' || *End != '\0' ||
+					Count == 0 || Count > UART_MACRO_REPEAT) {
+				xil_printf("ERR bad repeat count %s (1 to %d)\r\n", Argv[2], UART_MACRO_REPEAT);
+				return XST_FAILURE;
+			}
+		}
+		return Replay(Table, M, (u32)Count, Ref);
+	}
+	if (strcmp(Argv[0], "macros") == 0) {
+		for (M = Macros; M < &Macros[UART_MACROS]; M++) {
+			if (M->Name[0] != '\0') xil_printf("  %s %d bytes\r\n", M->Name, M->Len);
+		}
+		return XST_SUCCESS;
+	}
+	if (strcmp(Argv[0], "help") == 0) {
+		Help(Table);
+		return XST_SUCCESS;
+	}
+
+	for (; Table->Name != NULL; Table++) {
+		if (strcmp(Argv[0], Table->Name) == 0) {
+			if (Argc - 1 < Table->MinArgs) {
+				xil_printf("ERR usage: %s %s\r\n", Table->Name, Table->Usage);
+				return XST_FAILURE;
+			}
+			return Table->Handler(Ref, Argc, Argv);
+		}
+	}
+	xil_printf("ERR unknown command %s\r\n", Argv[0]);
+	return XST_FAILURE;
+}
+
+#ifndef FIXTURE_HOST
+#include <string.h>
+#include "xparameters.h"
+#include "xuartps.h"
+
+#define UART_DEVICE_ID		XPAR_XUARTPS_0_DEVICE_ID
+#define UART_INT_ID			XPAR_XUARTPS_0_INTR
+#define UART_RX_TRIGGER		8		/* Bytes in the RX FIFO before RXOVR */
+#define UART_RX_TIMEOUT		4		/* x4 bit periods of idle line before TOUT */
+#define UART_RX_IRQ_MASK	(XUARTPS_IXR_RXOVR | XUARTPS_IXR_RXFULL | \
+							 XUARTPS_IXR_TOUT | XUARTPS_IXR_OVER)
+#define TX_RING_MASK		(UART_TX_RING_SIZE - 1)
+
+static XUartPs uart;
+
+static u8 TxRing[UART_TX_RING_SIZE];
+static volatile u32 TxHead;			/* Written by the producer only */
+static volatile u32 TxTail;			/* Written by TxFill() only */
+static volatile u32 TxActive;		/* TX-empty interrupt enabled */
+static volatile u32 TxDrops;
+static int TxReady;
+
+/*
+ * Move queued bytes into the TX FIFO until it is full or TxRing is empty.
+ */
+static void TxFill(u32 BaseAddress)
+{
+	u32 Tail = TxTail;
+
+	while (Tail != TxHead && !XUartPs_IsTransmitFull(BaseAddress)) {
+		XUartPs_WriteReg(BaseAddress, XUARTPS_FIFO_OFFSET, TxRing[Tail]);
+		Tail = (Tail + 1) & TX_RING_MASK;
+	}
+	TxTail = Tail;
+}
+
+/*
+ * Start the transmitter after new bytes were queued. The TX-empty interrupt is
+ * masked while the FIFO is primed so TxFill() never runs twice at once.
+ */
+static void TxKick(void)
+{
+	u32 BaseAddress = uart.Config.BaseAddress;
+
+	XUartPs_WriteReg(BaseAddress, XUARTPS_IDR_OFFSET, XUARTPS_IXR_TXEMPTY);
+	TxFill(BaseAddress);
+	if (TxTail != TxHead) {
+		TxActive = 1;
+		XUartPs_WriteReg(BaseAddress, XUARTPS_IER_OFFSET, XUARTPS_IXR_TXEMPTY);
+	}
+	else {
+		TxActive = 0;
+	}
+}
+
+static u32 TxFree(void)
+{
+	return (TxTail - TxHead - 1) & TX_RING_MASK;
+}
+
+/*
+ * Drain the RX FIFO into RxRing on RXOVR, RXFULL and RX timeout, and refill
+ * the TX FIFO from TxRing on TX empty.
+ */
+static void UartIsr(void *CallBackRef)
+{
+	XUartPs *InstancePtr = (XUartPs *)CallBackRef;
+	u32 BaseAddress = InstancePtr->Config.BaseAddress;
+	u32 IsrStatus;
+
+	IsrStatus = XUartPs_ReadReg(BaseAddress, XUARTPS_IMR_OFFSET) &
+			XUartPs_ReadReg(BaseAddress, XUARTPS_ISR_OFFSET);
+
+	while (XUartPs_IsReceiveData(BaseAddress)) {
+		RxPut((u8)XUartPs_ReadReg(BaseAddress, XUARTPS_FIFO_OFFSET));
+	}
+	if (IsrStatus & XUARTPS_IXR_OVER) {
+		RxOverruns++;
+	}
+
+	if (IsrStatus & XUARTPS_IXR_TXEMPTY) {
+		TxFill(BaseAddress);
+		if (TxTail == TxHead) {
+			TxActive = 0;
+			XUartPs_WriteReg(BaseAddress, XUARTPS_IDR_OFFSET, XUARTPS_IXR_TXEMPTY);
+		}
+	}
+
+	XUartPs_WriteReg(BaseAddress, XUARTPS_ISR_OFFSET, IsrStatus);
+}
+
+int UartCli_Init(u32 Rate)
+{
+	XUartPs_Config *config;
+	int Status;
+
+	config = XUartPs_LookupConfig(UART_DEVICE_ID);
+	if (config == NULL) {
+		return XST_FAILURE;
+	}
+	XUartPs_CfgInitialize(&uart, config, config->BaseAddress);
+
+	Status = XUartPs_SetBaudRate(&uart, Rate);
+	if (Status != XST_SUCCESS) {
+		xil_printf("Failed to set baud rate\r\n");
+		return Status;
+	}
+	BaudRate = Rate;
+
+	Status = Intc_Init();
+	if (Status != XST_SUCCESS) {
+		xil_printf("Interrupt controller init failed\r\n");
+		return Status;
+	}
+	Status = Intc_Connect(UART_INT_ID, UartIsr, &uart);
+	if (Status != XST_SUCCESS) {
+		xil_printf("Failed to connect UART interrupt\r\n");
+		return Status;
+	}
+
+	XUartPs_SetFifoThreshold(&uart, UART_RX_TRIGGER);
+	XUartPs_SetRecvTimeout(&uart, UART_RX_TIMEOUT);
+	XUartPs_SetInterruptMask(&uart, UART_RX_IRQ_MASK);
+	TxReady = 1;
+
+	return XST_SUCCESS;
+}
+
+/*
+ * Wait until everything queued has left the transmitter.
+ */
+void UartCli_Flush(void)
+{
+	u32 BaseAddress = uart.Config.BaseAddress;
+
+	if (!TxReady) {
+		return;
+	}
+	while (TxActive || TxTail != TxHead) {
+		if (!TxActive) TxKick();
+	}
+	while (!(XUartPs_ReadReg(BaseAddress, XUARTPS_SR_OFFSET) & XUARTPS_SR_TXEMPTY));
+}
+
+int UartCli_SetBaudRate(u32 Rate)
+{
+	int Status;
+
+	UartCli_Flush();
+	Status = XUartPs_SetBaudRate(&uart, Rate);
+	if (Status == XST_SUCCESS) {
+		BaudRate = Rate;
+	}
+	return Status;
+}
+
+u32 UartCli_TxDrops(void)
+{
+	return TxDrops;
+}
+
+/*
+ * Bytes UartCli_Send() can take right now without dropping.
+ */
+u32 UartCli_TxFree(void)
+{
+	return TxReady ? TxFree() : UART_TX_RING_SIZE;
+}
+
+static void RxPoll(void)
+{
+	/* RxRing is filled by UartIsr() */
+}
+
+int UartCli_IsOpen(void)
+{
+	return TRUE;
+}
+
+/****************************************************************************/
+/**
+*
+* Queue Len bytes for transmission without waiting for the UART. If TxRing
+* cannot take the whole buffer it is dropped and counted, so a binary record
+* is either sent complete or not at all.
+*
+* @param	Buf is the data to send.
+* @param	Len is the number of bytes in Buf.
+*
+* @return	None.
+*
+*****************************************************************************/
+void UartCli_Send(const u8 *Buf, u32 Len)
+{
+	u32 Head = TxHead;
+	u32 First;
+
+	if (!TxReady) {
+		while (Len--) {
+			XUartPs_SendByte(STDOUT_BASEADDRESS, *Buf++);
+		}
+		return;
+	}
+	if (Len > TxFree()) {
+		TxDrops++;
+		return;
+	}
+
+	First = UART_TX_RING_SIZE - Head;
+	if (First > Len) First = Len;
+	memcpy(&TxRing[Head], Buf, First);
+	memcpy(&TxRing[0], Buf + First, Len - First);
+	TxHead = (Head + Len) & TX_RING_MASK;
+
+	if (!TxActive) {
+		TxKick();
+	}
+}
+
+/*
+ * Queue text for transmission, waiting for room in TxRing chunk by chunk
+ * like outbyte() instead of dropping it.
+ */
+void UartCli_Write(const u8 *Buf, u32 Len)
+{
+	u32 Chunk;
+
+	while (Len != 0) {
+		Chunk = TxFree();
+		if (Chunk == 0) {
+			if (!TxActive) TxKick();
+			continue;
+		}
+		if (Chunk > Len) Chunk = Len;
+		UartCli_Send(Buf, Chunk);
+		Buf += Chunk;
+		Len -= Chunk;
+	}
+}
+
+/*
+ * Replaces the BSP outbyte() so xil_printf output is queued in TxRing too.
+ * Text output waits for room rather than losing characters.
+ */
+void outbyte(char c)
+{
+	if (!TxReady) {
+		XUartPs_SendByte(STDOUT_BASEADDRESS, c);
+		return;
+	}
+	while (TxFree() == 0) {
+		if (!TxActive) TxKick();
+	}
+	TxRing[TxHead] = (u8)c;
+	TxHead = (TxHead + 1) & TX_RING_MASK;
+	if (!TxActive) {
+		TxKick();
+	}
+}
+
+#else /* FIXTURE_HOST */
+
+static int StdinClosed;
+
+int UartCli_Init(u32 Rate)
+{
+	BaudRate = Rate;
+	setvbuf(stdout, NULL, _IOFBF, 1 << 16);
+	return XST_SUCCESS;
+}
+
+void UartCli_Flush(void)
+{
+	fflush(stdout);
+}
+
+int UartCli_SetBaudRate(u32 Rate)
+{
+	UartCli_Flush();
+	BaudRate = Rate;
+	return XST_SUCCESS;
+}
+
+u32 UartCli_TxDrops(void)
+{
+	return 0;
+}
+
+u32 UartCli_TxFree(void)
+{
+	return UART_TX_RING_SIZE;
+}
+
+/*
+ * Stand-in for the RX interrupt: move whatever stdin has ready into RxRing.
+ */
+static void RxPoll(void)
+{
+	struct pollfd Fd;
+	u8 Buf[64];
+	ssize_t Len;
+	ssize_t i;
+
+	if (StdinClosed) {
+		return;
+	}
+
+	Fd.fd = STDIN_FILENO;
+	Fd.events = POLLIN;
+	if (poll(&Fd, 1, 0) <= 0) {
+		return;
+	}
+	Len = read(STDIN_FILENO, Buf, sizeof(Buf));
+	if (Len <= 0) {
+		StdinClosed = 1;
+		return;
+	}
+	for (i = 0; i < Len; i++) {
+		RxPut(Buf[i]);
+	}
+}
+
+int UartCli_IsOpen(void)
+{
+	fflush(stdout);
+	return RxHead != RxTail || !StdinClosed;
+}
+
+void UartCli_Send(const u8 *Buf, u32 Len)
+{
+	fwrite(Buf, 1, Len, stdout);
+}
+
+void UartCli_Write(const u8 *Buf, u32 Len)
+{
+	fwrite(Buf, 1, Len, stdout);
+}
+
+#endif
@@ -1,2 +1,73 @@
+/******************************************************************************
+* uart_cli.h: PS UART access for the fixture console
+*
+* The Xilinx BSP backend drives XUartPs 0 with its receiver in interrupt mode;
+* the FIXTURE_HOST backend reads stdin without blocking and writes to stdout.
+* Either way received bytes are queued in a ring buffer, so
+* UartCli_TryRecvByte() never waits. On the board, transmit is interrupt
+* driven from a second ring buffer; see uart_cli.c.
+*
+* UartCli_ReadLine() assembles command lines from the received bytes and
+* UartCli_Execute() splits a line into words and calls the matching entry of
+* a command table. Named macros are kept in RAM:
+*
+*   def NAME      record the following lines instead of running them
+*   end           stop recording
+*   do NAME [N]   replay macro NAME N times (default 1) back to back
+*   macros        list the macros and their sizes
+*   help          list the commands of the table
+******************************************************************************/
+#ifndef UART_CLI_H
+#define UART_CLI_H
 
+#include "fixture.h"
 
+#ifndef UART_BAUD_RATE
+#define UART_BAUD_RATE		115200
+#endif
+/* Rates selectable at run time, see UartCli_NextBaudRate() */
+#define UART_BAUD_TABLE		115200, 460800, 921600, 1843200
+#define UART_RX_RING_SIZE	1024	/* Power of two, holds a pasted script */
+#define UART_TX_RING_SIZE	8192	/* Power of two */
+
+#define UART_LINE_SIZE		80
+#define UART_MAX_ARGS		8
+#define UART_MACROS			8
+#define UART_MACRO_NAME		12
+#define UART_MACRO_SIZE		1024	/* Bytes of command text per macro */
+#define UART_MACRO_DEPTH	4		/* Nesting limit of do */
+#define UART_MACRO_REPEAT	100000	/* Largest N of do NAME N */
+#define UART_CANCEL			0x03	/* Ctrl-C, stops a run or capture */
+
+/* Handler of one command; Argv[0] is the command name */
+typedef int (*UartCli_Handler)(void *Ref, int Argc, char *Argv[]);
+
+typedef struct {
+	const char *Name;
+	int MinArgs;			/* Words after the name */
+	UartCli_Handler Handler;
+	const char *Usage;
+} UartCli_Command;
+
+int UartCli_Init(u32 Rate);
+int UartCli_IsReceiveData(void);
+u8 UartCli_RecvByte(void);
+int UartCli_TryRecvByte(u8 *Byte);
+int UartCli_TryRecvCancel(void);
+u32 UartCli_RxOverruns(void);
+int UartCli_IsOpen(void);
+void UartCli_Send(const u8 *Buf, u32 Len);
+void UartCli_Write(const u8 *Buf, u32 Len);
+void UartCli_Flush(void);
+u32 UartCli_TxDrops(void);
+u32 UartCli_TxFree(void);
+
+int UartCli_SetBaudRate(u32 Rate);
+int UartCli_NextBaudRate(void);
+u32 UartCli_BaudRate(void);
+
+int UartCli_ReadLine(char *Line, u32 Size, int Echo);
+int UartCli_Execute(const UartCli_Command *Table, char *Line, void *Ref);
+int UartCli_IsRecording(void);
+
+#endif